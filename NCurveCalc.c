@@ -17,6 +17,14 @@
 #include "point.h"
 #include "clist.h"
 #include "curve.h"
+#include "curveio.h"
+#include "batch.h"
+#include "perf.h"
+#include "range.h"
+#include "simplify.h"
+#include "plot.h"
+#include "loader.h"
+#include "workspace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -83,40 +91,25 @@ void clrscr()
 }
 
 /* @brief Shows number of loaded coordinates
- * @param *list Target List
+ * @param *curve Target Curve
  * */
-void coordinatesLoaded(List *list)
+void coordinatesLoaded(Curve *curve)
 {
-    if (list->size == 0)
+    if (curve->size == 0)
         printw("@No coordinates loaded.\n");
-    else if (list->size == 1)
+    else if (curve->size == 1)
         printw("@1 coordinate loaded.\n");
     else
-        printw("@%i coordinates loaded.\n", list->size);
+        printw("@%zu coordinates loaded.\n", curve->size);
     refresh();
 }
 
-/* @brief Clear list of Points 
+/* @brief Clear Points of a Curve 
  * @param *curve Target Curve
  * */
 void clearCurve(Curve *curve)
 {
-    Node *node;
-    Node *node_now;
-    Point *loopPoint;
-    node = curve->list->head_node;
-    if (curve->list != NULL && curve->list->size > 0)
-    {
-        while (node != NULL)
-        {
-            node_now = node;
-            node = node_GetNext(node);
-            loopPoint = node_now->data;
-            rmPoint(loopPoint);
-            rmNode(node_now);
-        }
-    }
-    curve->list = mkList();
+    curve_Clear(curve);
 }
 
 /* @brief Test if file exists 
@@ -136,17 +129,360 @@ bool fileExists(char *inputFileName)
     return exists >= 0;
 }
 
+/* @brief Displays the hot path timings & allocation counts
+ * */
+void performanceScreen()
+{
+    PerfCounter counter;
+    size_t count, bytes;
+    int loopVar;
+    printw("@Performance since start:\n");
+    printw("\t%-12s %8s %12s %10s %14s\n", "Path", "Calls", "Time (ms)", "MB", "Points");
+    for (loopVar = 0; loopVar < PERF_SECTION_COUNT; loopVar++)
+    {
+        perf_Get(loopVar, &counter);
+        printw("\t%-12s %8zu %12.3f %10.3f %14zu\n", perf_SectionName(loopVar), counter.calls,
+               counter.seconds * 1e3, counter.bytes / (1024.0 * 1024.0), counter.points);
+    }
+    printw("\n\t%-12s %12s %10s\n", "Allocation", "Count", "MB");
+    for (loopVar = 0; loopVar < PERF_ALLOC_COUNT; loopVar++)
+    {
+        count = perf_GetAlloc(loopVar, &bytes);
+        printw("\t%-12s %12zu %10.3f\n", perf_AllocName(loopVar), count, bytes / (1024.0 * 1024.0));
+    }
+    anyKey();
+}
+
+/* @brief Displays one row per file of a Workspace
+ * @param *workspace Target Workspace
+ * */
+void workspaceTable(Workspace *workspace)
+{
+    WorkspaceEntry *entry;
+    double length, area;
+    size_t index;
+    printw("\t%-24s %10s %14s %14s %10s %-14s %10s\n", "File", "Points", "Length", "Area", "Memory KB", "Status",
+           "Time (ms)");
+    for (index = 0; index < workspace->count; index++)
+    {
+        entry = &workspace->entries[index];
+        if (entry->isLoaded && workspaceEntry_Stats(entry, &length, &area))
+            printw("\t%-24.24s %10zu %14.4f %14.4f %10zu %-14s %10.3f\n", entry->fileName,
+                   workspaceEntry_Points(entry), length, area, workspaceEntry_Bytes(entry) / 1024,
+                   workspaceEntry_Status(entry), entry->seconds * 1e3);
+        else
+            printw("\t%-24.24s %10zu %14s %14s %10zu %-14s %10.3f\n", entry->fileName,
+                   workspaceEntry_Points(entry), "-", "-", workspaceEntry_Bytes(entry) / 1024,
+                   workspaceEntry_Status(entry), entry->seconds * 1e3);
+    }
+}
+
+/* @brief Scrollable table of the points of a Curve
+ *
+ * Only the rows that fit the window are read & drawn, so every key is
+ * answered in the same time whatever the size of the curve.
+ * @param *curve Target Curve
+ * */
+void pointViewer(Curve *curve)
+{
+    Point loopPoint;
+    size_t top = 0;
+    size_t rows, loopVar, lastTop;
+    double jumpX;
+    unsigned long jumpIndex;
+    int key;
+    bool continueLoop = true;
+    savetty();
+    cbreak();
+    noecho();
+    keypad(stdscr, TRUE);
+    while (continueLoop)
+    {
+        /* Two header lines & one help line around the rows */
+        rows = LINES > 4 ? (size_t) LINES - 3 : 1;
+        lastTop = curve->size > rows ? curve->size - rows : 0;
+        if (top > lastTop)
+            top = lastTop;
+        erase();
+        mvprintw(0, 0, "@Points %zu-%zu of %zu:", top + 1,
+                 top + rows < curve->size ? top + rows : curve->size, curve->size);
+        mvprintw(1, 0, "\t%12s %20s %20s", "Index", "X", "Y");
+        for (loopVar = 0; loopVar < rows && top + loopVar < curve->size; loopVar++)
+        {
+            loopPoint = curve_GetAt(curve, top + loopVar);
+            mvprintw(2 + loopVar, 0, "\t%12zu %20lf %20lf", top + loopVar + 1, loopPoint.x, loopPoint.y);
+        }
+        mvprintw(LINES - 1, 0, "PgUp/PgDn or P/N page, arrows, Home/End, I index, F find x, X exit");
+        refresh();
+        key = getch();
+        switch (key)
+        {
+            case KEY_NPAGE:
+            case 'n':
+            case 'N':
+            case ' ':
+                top += rows;
+                break;
+            case KEY_PPAGE:
+            case 'p':
+            case 'P':
+                top = top > rows ? top - rows : 0;
+                break;
+            case KEY_DOWN:
+                top++;
+                break;
+            case KEY_UP:
+                if (top > 0)
+                    top--;
+                break;
+            case KEY_HOME:
+                top = 0;
+                break;
+            case KEY_END:
+                top = lastTop;
+                break;
+            case 'i':
+            case 'I':
+                echo();
+                mvprintw(LINES - 1, 0, "Index: ");
+                clrtoeol();
+                refresh();
+                if (scanw(" %lu", &jumpIndex) == 1 && jumpIndex > 0)
+                    top = jumpIndex - 1 < curve->size ? jumpIndex - 1 : curve->size - 1;
+                noecho();
+                break;
+            case 'f':
+            case 'F':
+                echo();
+                mvprintw(LINES - 1, 0, "X: ");
+                clrtoeol();
+                refresh();
+                if (scanw(" %lf", &jumpX) == 1)
+                    top = curve_FindX(curve, jumpX);
+                noecho();
+                break;
+            case 'x':
+            case 'X':
+            case 'q':
+            case 'Q':
+                continueLoop = false;
+                break;
+            default:
+                break;
+        }
+    }
+    keypad(stdscr, FALSE);
+    resetty();
+}
+
+/* @brief Draws a Curve as a terminal plot with zoom & pan
+ *
+ * Each column shows the lowest to highest y of the points under it,
+ * read from a PlotIndex, so drawing costs the same whatever the size of
+ * the curve.
+ * @param *curve Target Curve
+ * */
+void plotScreen(Curve *curve)
+{
+    PlotIndex *index;
+    double *lows = NULL;
+    double *highs = NULL;
+    double firstX, lastX, fromX, toX, span, lowY, highY, swap;
+    size_t columns = 0;
+    size_t column;
+    int rows, row, rowLow, rowHigh, key;
+    bool continueLoop = true;
+    index = mkPlotIndex(curve);
+    if (index == NULL)
+    {
+        printw("@Not enough memory to plot.\n");
+        anyKey();
+        return;
+    }
+    firstX = fmin(curve_GetAt(curve, 0).x, curve_GetAt(curve, curve->size - 1).x);
+    lastX = fmax(curve_GetAt(curve, 0).x, curve_GetAt(curve, curve->size - 1).x);
+    fromX = firstX;
+    toX = lastX > firstX ? lastX : firstX + 1;
+    savetty();
+    cbreak();
+    noecho();
+    keypad(stdscr, TRUE);
+    while (continueLoop)
+    {
+        /* One header line & one help line around the plot */
+        rows = LINES > 3 ? LINES - 2 : 1;
+        if (columns != (size_t) COLS)
+        {
+            columns = COLS > 0 ? COLS : 1;
+            free(lows);
+            free(highs);
+            lows = (double *) malloc(columns * sizeof(double));
+            highs = (double *) malloc(columns * sizeof(double));
+            if (lows == NULL || highs == NULL)
+                break;
+        }
+        curve_PlotColumns(index, curve, fromX, toX, columns, lows, highs);
+        lowY = INFINITY;
+        highY = -INFINITY;
+        for (column = 0; column < columns; column++)
+        {
+            lowY = fmin(lowY, lows[column]);
+            highY = fmax(highY, highs[column]);
+        }
+        if (!(lowY < highY))
+        {
+            lowY = isfinite(lowY) ? lowY - 1 : -1;
+            highY = lowY + 2;
+        }
+        erase();
+        mvprintw(0, 0, "@X: %lf to %lf  Y: %lf to %lf", fromX, toX, lowY, highY);
+        for (column = 0; column < columns; column++)
+        {
+            if (isnan(lows[column]))
+                continue;
+            rowHigh = 1 + (int) ((highY - highs[column]) / (highY - lowY) * (rows - 1) + 0.5);
+            rowLow = 1 + (int) ((highY - lows[column]) / (highY - lowY) * (rows - 1) + 0.5);
+            for (row = rowHigh; row <= rowLow; row++)
+                mvaddch(row, column, '*');
+        }
+        mvprintw(LINES - 1, 0, "+/- zoom, arrows or H/L pan, Z set range, R reset, X exit");
+        refresh();
+        key = getch();
+        span = toX - fromX;
+        switch (key)
+        {
+            case '+':
+            case '=':
+                /* Stop before columns get narrower than a double can tell */
+                if (span / 2 > fmax(fabs(fromX), fabs(toX)) * 1e-12)
+                {
+                    fromX += span / 4;
+                    toX -= span / 4;
+                }
+                break;
+            case '-':
+                fromX -= span / 2;
+                toX += span / 2;
+                break;
+            case KEY_LEFT:
+            case 'h':
+            case 'H':
+                fromX -= span / 4;
+                toX -= span / 4;
+                break;
+            case KEY_RIGHT:
+            case 'l':
+            case 'L':
+                fromX += span / 4;
+                toX += span / 4;
+                break;
+            case 'r':
+            case 'R':
+                fromX = firstX;
+                toX = lastX > firstX ? lastX : firstX + 1;
+                break;
+            case 'z':
+            case 'Z':
+                echo();
+                mvprintw(LINES - 1, 0, "From X: ");
+                clrtoeol();
+                refresh();
+                if (scanw(" %lf", &fromX) == 1)
+                {
+                    mvprintw(LINES - 1, 0, "To X: ");
+                    clrtoeol();
+                    refresh();
+                    if (scanw(" %lf", &toX) != 1)
+                        toX = fromX + span;
+                }
+                else
+                {
+                    fromX = toX - span;
+                }
+                noecho();
+                if (fromX > toX)
+                {
+                    swap = fromX;
+                    fromX = toX;
+                    toX = swap;
+                }
+                if (!(fromX < toX))
+                    toX = fromX + span;
+                break;
+            case 'x':
+            case 'X':
+            case 'q':
+            case 'Q':
+                continueLoop = false;
+                break;
+            default:
+                break;
+        }
+    }
+    keypad(stdscr, FALSE);
+    resetty();
+    free(lows);
+    free(highs);
+    rmPlotIndex(index);
+}
+
+/* @brief Shows the progress of a background load until it ends
+ *
+ * Redraws about ten times a second, any key cancels the load.
+ * @param *load Target AsyncLoad
+ * */
+void loadProgressScreen(AsyncLoad *load)
+{
+    LoadInfo info;
+    size_t totalBytes;
+    double fraction, eta;
+    int row, column;
+    bool isCancelled = false;
+    getyx(stdscr, row, column);
+    savetty();
+    cbreak();
+    noecho();
+    timeout(100);
+    while (!asyncLoad_IsDone(load))
+    {
+        asyncLoad_Progress(load, &totalBytes, &info);
+        fraction = totalBytes > 0 ? (double) info.bytes / totalBytes : 0;
+        mvprintw(row, column, "@Loaded %.1f of %.1f MB (%.0f%%), %zu points, %.1f MB/s",
+                 info.bytes / (1024.0 * 1024.0), totalBytes / (1024.0 * 1024.0), fraction * 100,
+                 info.points, loadInfo_Throughput(&info));
+        clrtoeol();
+        eta = fraction > 0 ? info.seconds * (1 - fraction) / fraction : 0;
+        if (isCancelled)
+            mvprintw(row + 1, column, "@Cancelling...");
+        else if (fraction > 0)
+            mvprintw(row + 1, column, "@About %.0f s left, press any key to cancel.", eta);
+        else
+            mvprintw(row + 1, column, "@Press any key to cancel.");
+        clrtoeol();
+        refresh();
+        if (getch() != ERR && !isCancelled)
+        {
+            asyncLoad_Cancel(load);
+            isCancelled = true;
+        }
+    }
+    timeout(-1);
+    resetty();
+    move(row, column);
+    clrtobot();
+}
+
 /* @brief Displays the Welcome Screen 
  * @param *curve Target Curve
  * @param *userInput Last input character
  * @param *isModified Boolean, are there unsaved changes
  * */
-void welcomescr(List *list, char userInput, bool isModified)
+void welcomescr(Curve *curve, char userInput, bool isModified)
 {
     printw("################################\n");
     printw("##########~NCurveCalc~##########\n");
     printw("################################\n");
-    coordinatesLoaded(list);
+    coordinatesLoaded(curve);
     if (isModified)
         printw("@There are unsaved changes.\n");
     printw("@Previous selection: %c\n\n", userInput);
@@ -154,6 +490,7 @@ void welcomescr(List *list, char userInput, bool isModified)
     printw("\tB - Analyze coordinates\n");
     printw("\tC - Modify coordinates\n");
     printw("\tD - Save changes\n");
+    printw("\tW - Workspace of several files\n");
     printw("\tX - Exit program\n");
     printw("\tSelection: ");
     refresh();
@@ -181,6 +518,10 @@ bool optionAFile(Curve *curve);
  */
 bool optionAInput(Curve *curve);
 
+/* @brief Main menu option A submenu for the precision of new loads
+ */
+void optionAPrecision();
+
 /* @brief Analyzes loaded coordinates 
  * @param *curve Target Curve
  */
@@ -199,6 +540,12 @@ bool optionC(Curve *curve, bool isModified);
  */
 bool optionD(Curve *curve);
 
+/* @brief Loads, analyzes, shifts & saves several curve files in parallel
+ *
+ * The files are separate from the loaded coordinates.
+ */
+void optionW();
+
 /* @brief Exit program
  * @param isModified Boolean isModified value
  * @return Returns program exit status
@@ -206,12 +553,21 @@ bool optionD(Curve *curve);
 bool optionX(bool isModified);
 /* endregion */
 
-int main()
+int main(int argc, char **argv)
 {
     ProgramStatus thisProgram;
     char userInput = ' ';
-    Curve *curve = (Curve *) malloc(sizeof(Curve));
-    curve->list = mkList();
+    Curve *curve;
+    int exitCode;
+    /* Command line arguments run a single batch command without curses */
+    if (isBatchMode(argc, argv))
+    {
+        exitCode = batchMain(argc, argv);
+        if (perf_IsDumpRequested())
+            perf_Print(stderr);
+        return exitCode;
+    }
+    curve = mkCurve();
     /* Clear terminal screen before initializing curses */
     #ifdef _WIN32
         system("cls");
@@ -224,7 +580,7 @@ int main()
     thisProgram.isModified = false;
     while (thisProgram.isRunning)
     {
-        welcomescr(curve->list, userInput, thisProgram.isModified);
+        welcomescr(curve, userInput, thisProgram.isModified);
         userInput = getLn();
         clrscr();
         switch(userInput)
@@ -233,23 +589,26 @@ int main()
                 thisProgram.isModified = optionA(curve, thisProgram.isModified);
                 break;
             case 'B':
-                if (curve->list->size > 0)
+                if (curve->size > 0)
                     optionB(curve);
                 else
                     loadCurve();
                 break;
             case 'C':
-                if (curve->list->size > 0)
+                if (curve->size > 0)
                     thisProgram.isModified = optionC(curve, thisProgram.isModified);
                 else
                     loadCurve();
                 break;
             case 'D':
-                if (curve->list->size > 0)
+                if (curve->size > 0)
                     thisProgram.isModified = optionD(curve);
                 else
                     loadCurve();
                 break;
+            case 'W':
+                optionW();
+                break;
             case 'X':
                 thisProgram.isRunning = optionX(thisProgram.isModified);
                 break;
@@ -259,10 +618,11 @@ int main()
         clrscr();
     }
     /* Free memory */
-    clearCurve(curve);
-    free(curve);
+    rmCurve(curve);
     /* End curses screen */
     endwin();
+    if (perf_IsDumpRequested())
+        perf_Print(stderr);
     /* Return to operating system */
     return 0;
 }
@@ -272,14 +632,16 @@ bool optionA(Curve *curve, bool isModified)
 {
     char userInput;
     bool continueLoop = true;
+    double step;
     while (continueLoop)
     {
         clrscr();
-        coordinatesLoaded(curve->list);
+        coordinatesLoaded(curve);
         printw("@Coordinate load menu:\n");
         printw("\tA - Load from file\n");
         printw("\tB - Load from input\n");
         printw("\tC - Clear points\n");
+        printw("\tD - Storage precision (now: %s)\n", precisionName(getLoadPrecision(&step)));
         printw("\tX - Main menu:\n");
         printw("\tSelection: ");
         refresh();
@@ -295,6 +657,9 @@ bool optionA(Curve *curve, bool isModified)
             case 'C':
                 clearCurve(curve);
                 break;
+            case 'D':
+                optionAPrecision();
+                break;
             case 'X':
                 continueLoop = false;
                 break;
@@ -302,7 +667,7 @@ bool optionA(Curve *curve, bool isModified)
                 invalidInput();
         }
     }
-    if (isModified)
+    if (isModified && !curve->isAnalyzed)
         initCurve(curve);
     return isModified;
 }
@@ -311,19 +676,19 @@ void optionB(Curve *curve)
 {
     char userInput;
     bool continueLoop = true;
-    int loopVar;
-    double length;
-    Node *node;
-    Node *node_now;
-    Point *loopPoint;
-    Point *loopPointNext;
+    double fromX, toX, rangeLength, rangeArea;
+    double lengthError, areaError;
     while (continueLoop)
     {
         clrscr();
-        coordinatesLoaded(curve->list);
+        coordinatesLoaded(curve);
         printw("@Analyze Points menu:\n");
         printw("\tA - Display points\n");
         printw("\tB - Point statistics\n");
+        printw("\tC - Verify statistics\n");
+        printw("\tD - Performance\n");
+        printw("\tE - Range statistics\n");
+        printw("\tF - Plot\n");
         printw("\tX - Main menu:\n");
         printw("\tSelection: ");
         refresh();
@@ -332,31 +697,64 @@ void optionB(Curve *curve)
         {
             case 'A':
                 clrscr();
-                loopVar = 0;
-                node = curve->list->head_node;
-                if (curve->list != NULL && curve->list->size > 0)
-                {
-                    while (node != NULL)
-                    {
-                        node_now = node;
-                        node = node_GetNext(node);
-                        loopPoint = node_now->data;
-                        loopVar++;
-                        clrscr();
-                        printw("@Point %i of %i:\n", loopVar, curve->list->size);
-                        printw("\tx: %lf\n\ty: %lf\n", loopPoint->x, loopPoint->y);
-                        anyKey();
-                    }
-                }
+                pointViewer(curve);
                 break;
             case 'B':
+                if (!curve->isAnalyzed)
+                    initCurve(curve);
                 printw("@Point statistics:\n");
                 printw("\tLength of points: %lf\n", curve->length);
                 printw("\tArea under the curve: %lf\n", curve->area);
-                printw("\tLowest point: X: %lf Y: %lf\n", curve->lowPoint->x, curve->lowPoint->y);
-                printw("\tHighest point: X: %lf Y: %lf\n", curve->highPoint->x, curve->highPoint->y);
+                printw("\tLowest point: X: %lf Y: %lf\n", curve->lowPoint.x, curve->lowPoint.y);
+                printw("\tHighest point: X: %lf Y: %lf\n", curve->highPoint.x, curve->highPoint.y);
+                if (curve->precision != PRECISION_DOUBLE)
+                {
+                    curve_ErrorBounds(curve, &lengthError, &areaError);
+                    if (curve->precision == PRECISION_FIXED)
+                        printw("\tStorage precision: fixed, step %g\n", curve->precisionStep);
+                    else
+                        printw("\tStorage precision: float\n");
+                    printw("\tQuantization error: X: +-%g Y: +-%g\n", curve->errorX, curve->errorY);
+                    printw("\tLength within +-%g, area within +-%g\n", lengthError, areaError);
+                }
+                anyKey();
+                break;
+            case 'C':
+                printw("@Rescanning %zu points...\n", curve->size);
+                refresh();
+                if (curve_Verify(curve))
+                    printw("@Statistics match a full rescan.\n");
+                else
+                    printw("@Statistics were out of date and have been recalculated.\n");
+                anyKey();
+                break;
+            case 'D':
+                clrscr();
+                performanceScreen();
+                break;
+            case 'E':
+                printw("@Range statistics:\n");
+                printw("\tFrom X: ");
+                refresh();
+                scanw(" %lf", &fromX);
+                printw("\tTo X: ");
+                refresh();
+                scanw(" %lf", &toX);
+                if (curve_RangeStats(curve, fromX, toX, &rangeLength, &rangeArea))
+                {
+                    printw("\tLength of points: %lf\n", rangeLength);
+                    printw("\tArea under the curve: %lf\n", rangeArea);
+                }
+                else
+                {
+                    printw("@Not enough memory for the range index.\n");
+                }
                 anyKey();
                 break;
+            case 'F':
+                clrscr();
+                plotScreen(curve);
+                break;
             case 'X':
                 continueLoop = false;
                 break;
@@ -372,12 +770,17 @@ bool optionC(Curve *curve, bool isModified)
     char userInput;
     bool continueLoop = true;
     double shiftX, shiftY;
+    double scaleX, scaleY;
+    double tolerance;
+    SimplifyInfo simplifyInfo;
     while (continueLoop)
     {
         clrscr();
-        coordinatesLoaded(curve->list);
+        coordinatesLoaded(curve);
         printw("@Modify Points menu:\n");
         printw("\tA - Shift Points\n");
+        printw("\tB - Scale Points\n");
+        printw("\tC - Simplify Points\n");
         printw("\tX - Main menu:\n");
         printw("\tSelection: ");
         refresh();
@@ -393,7 +796,42 @@ bool optionC(Curve *curve, bool isModified)
                 refresh();
                 scanw(" %lf", &shiftY);
                 mvCurve(curve, shiftX, shiftY);
-                initCurve(curve);
+                isModified = true;
+                break;
+            case 'B':
+                printw("@Scale Points:\n");
+                printw("\tX: ");
+                refresh();
+                scanw(" %lf", &scaleX);
+                printw("\tY: ");
+                refresh();
+                scanw(" %lf", &scaleY);
+                curve_Transform(curve, scaleX, scaleY, 0, 0);
+                isModified = true;
+                break;
+            case 'C':
+                printw("@Simplify Points:\n");
+                printw("\tTolerance: ");
+                refresh();
+                scanw(" %lf", &tolerance);
+                printw("@Simplifying %zu points...\n", curve->size);
+                refresh();
+                if (!curve_Simplify(curve, tolerance, &simplifyInfo))
+                {
+                    printw("@Not enough memory to simplify.\n");
+                }
+                else
+                {
+                    printw("\tPoints removed: %zu\n", simplifyInfo.removed);
+                    printw("\tMemory freed: %zu KB\n", simplifyInfo.freedBytes / 1024);
+                    printw("\tLength: %lf (error %lf)\n", simplifyInfo.lengthAfter,
+                           simplifyInfo.lengthAfter - simplifyInfo.lengthBefore);
+                    printw("\tArea under the curve: %lf (error %lf)\n", simplifyInfo.areaAfter,
+                           simplifyInfo.areaAfter - simplifyInfo.areaBefore);
+                    if (simplifyInfo.removed > 0)
+                        isModified = true;
+                }
+                anyKey();
                 break;
             case 'X':
                 continueLoop = false;
@@ -402,6 +840,7 @@ bool optionC(Curve *curve, bool isModified)
                 invalidInput();
         }
     }
+    return isModified;
 }
 
 bool optionD(Curve *curve)
@@ -410,16 +849,14 @@ bool optionD(Curve *curve)
     bool continueLoop = true;
     char *inputFileName = (char *) malloc(64 * sizeof(char));
     bool isSaved = false;
-    Node *node;
-    Node *node_now;
-    Point *loopPoint;
-    FILE *outputFile;
+    bool isDurable;
     while (continueLoop)
     {
         clrscr();
-        coordinatesLoaded(curve->list);
+        coordinatesLoaded(curve);
         printw("@Save changes:\n");
-        printw("\tA - Save to file\n");
+        printw("\tA - Save to file (.ncb for binary)\n");
+        printw("\tB - Save to file, synced & renamed into place\n");
         printw("\tX - Main menu:\n");
         printw("\tSelection: ");
         refresh();
@@ -427,6 +864,8 @@ bool optionD(Curve *curve)
         switch (userInput)
         {
             case 'A':
+            case 'B':
+                isDurable = userInput == 'B';
                 printw("\tPlease input file name: ");
                 scanw(" %s", inputFileName);
                 if (fileExists(inputFileName))
@@ -437,22 +876,14 @@ bool optionD(Curve *curve)
                 }
                 else
                 {
-                    outputFile = fopen(inputFileName, "w");
-                    node = curve->list->head_node;
-                    if (curve->list != NULL && curve->list->size > 0)
-                    {
-                        loopPoint = node->data;
-                        while (node != NULL)
-                        {
-                            node_now = node;
-                            node = node_GetNext(node);
-                            loopPoint = node_now->data;
-                            fprintf(outputFile, "%lf %lf\n", loopPoint->x, loopPoint->y);
-                        }
-                    }
-                    fclose(outputFile);
-                    isSaved = true;
-                    printw("File save complete.\n");
+                    if (isBinaryName(inputFileName))
+                        isSaved = curve_SaveBinary(curve, inputFileName, isDurable);
+                    else
+                        isSaved = curve_SaveText(curve, inputFileName, isDurable);
+                    if (isSaved)
+                        printw("File save complete.\n");
+                    else
+                        printw("@File could not be written!\n");
                     anyKey();
                 }
                 break;
@@ -467,6 +898,116 @@ bool optionD(Curve *curve)
     return !isSaved;
 }
 
+void optionW()
+{
+    char userInput;
+    bool continueLoop = true;
+    char *inputName = (char *) malloc(256 * sizeof(char));
+    Workspace *workspace = mkWorkspace(0);
+    double shiftX, shiftY;
+    size_t failures;
+    int added;
+    if (inputName == NULL || workspace == NULL)
+    {
+        printw("@Not enough memory for a workspace!\n");
+        anyKey();
+        free(inputName);
+        rmWorkspace(workspace);
+        return;
+    }
+    while (continueLoop)
+    {
+        clrscr();
+        printw("@Workspace (files: %zu, threads: %d):\n", workspace->count, workerPool_Threads(workspace->pool));
+        workspaceTable(workspace);
+        printw("\n\tA - Add file\n");
+        printw("\tB - Add every file of a directory\n");
+        printw("\tC - Load all\n");
+        printw("\tD - Analyze all\n");
+        printw("\tE - Shift all\n");
+        printw("\tF - Save all to a directory\n");
+        printw("\tG - Compress all\n");
+        printw("\tX - Main menu:\n");
+        printw("\tSelection: ");
+        refresh();
+        userInput = getLn();
+        switch (userInput)
+        {
+            case 'A':
+                printw("\tPlease input file name: ");
+                refresh();
+                scanw(" %255s", inputName);
+                if (!fileExists(inputName))
+                {
+                    printw("@File does not exist!\n");
+                    anyKey();
+                }
+                else if (!workspace_Add(workspace, inputName))
+                {
+                    printw("@Not enough memory to add the file!\n");
+                    anyKey();
+                }
+                break;
+            case 'B':
+                printw("\tPlease input directory: ");
+                refresh();
+                scanw(" %255s", inputName);
+                added = workspace_AddDirectory(workspace, inputName);
+                if (added < 0)
+                    printw("@Directory could not be read!\n");
+                else
+                    printw("@Added %d files.\n", added);
+                anyKey();
+                break;
+            case 'C':
+                printw("@Loading %zu files...\n", workspace->count);
+                refresh();
+                printw("@Loaded %zu files.\n", workspace_Load(workspace));
+                anyKey();
+                break;
+            case 'D':
+                workspace_Analyze(workspace);
+                break;
+            case 'E':
+                printw("@Shift Points:\n");
+                printw("\tX: ");
+                refresh();
+                scanw(" %lf", &shiftX);
+                printw("\tY: ");
+                refresh();
+                scanw(" %lf", &shiftY);
+                workspace_Shift(workspace, shiftX, shiftY);
+                break;
+            case 'F':
+                printw("\tPlease input directory: ");
+                refresh();
+                scanw(" %255s", inputName);
+                failures = workspace_Save(workspace, inputName, false);
+                if (failures > 0)
+                    printw("@%zu files could not be written or exist!\n", failures);
+                else
+                    printw("File save complete.\n");
+                anyKey();
+                break;
+            case 'G':
+                failures = workspace_Pack(workspace);
+                if (failures > 0)
+                {
+                    printw("@Not enough memory to compress %zu files!\n", failures);
+                    anyKey();
+                }
+                break;
+            case 'X':
+                continueLoop = false;
+                break;
+            default:
+                invalidInput();
+        }
+    }
+    free(inputName);
+    rmWorkspace(workspace);
+}
+
 bool optionX(bool isModified)
 {
     char userInput;
@@ -503,18 +1044,13 @@ bool optionX(bool isModified)
 bool optionAFile(Curve *curve)
 {
     char userInput;
-    Node *lastNode;
-    Point *newPoint;
-    Point *lastPoint;
-    double x, y, sequence;
     bool isModified = false;
-    bool continueLoop = true;
     char *inputFileName = (char *) malloc(64 * sizeof(char));
-    bool gotDirection = false;
-    bool typeDirection; /*True: Smaller False: Larger*/
-    FILE *inputFile;
+    AsyncLoad *load;
+    LoadStatus status;
+    LoadInfo info;
     clrscr();
-    if (curve->list->size > 0)
+    if (curve->size > 0)
     {
         printw("@Your previous coordinates will be removed, continue? (y/n)\n");
         printw("\tSelection: ");
@@ -522,8 +1058,6 @@ bool optionAFile(Curve *curve)
         userInput = getLn();
         if (userInput == 'N')
             return isModified;
-        else
-            clearCurve(curve);
     }
     printw("@Please input file name: ");
     refresh();
@@ -535,59 +1069,58 @@ bool optionAFile(Curve *curve)
         getLn();
         return isModified;
     }
-    inputFile = fopen(inputFileName, "r");
-    if (inputFile != NULL)
-        isModified = true;
-    while (fscanf(inputFile, "%lf %lf", &x, &y) == 2)
+    load = mkAsyncLoad(inputFileName);
+    free(inputFileName);
+    if (load == NULL)
     {
-        lastNode = curve->list->tail_node;
-        if (lastNode != NULL)
-        {
-            lastPoint = lastNode->data;
-            if (!gotDirection)
-            {
-                gotDirection = true;
-                if (x <= lastPoint->x)
-                    typeDirection = true;
-                else
-                    typeDirection = false;
-            }
-            if (x <= lastPoint->x && typeDirection)
-            {
-                newPoint = mkPoint(x, y);
-                list_Append(curve->list, newPoint);
-            }
-            else if (x >= lastPoint->x && !typeDirection)
-            {
-                newPoint = mkPoint(x, y);
-                list_Append(curve->list, newPoint);
-            }
-            else
-            {
-                printw("\t@Values must be sequential!\n\tPlease fix your file!\n");
-                anyKey();
-                return isModified;
-            }
-        }
-        else
-        {
-            newPoint = mkPoint(x, y);
-            list_Append(curve->list, newPoint);
-        }
+        printw("@Not enough memory to load the file!\n");
+        anyKey();
+        return isModified;
     }
-    fclose(inputFile);
-    free(inputFileName);
+    loadProgressScreen(load);
+    /* The previous points are kept if the file could not be read, has a
+     * bad format, does not fit the precision or the load was cancelled.
+     * Otherwise, including LOAD_SEQUENCE & LOAD_NOMEMORY, the points read
+     * so far replace them */
+    status = asyncLoad_Finish(load, curve, &info);
+    rmAsyncLoad(load);
+    switch (status)
+    {
+        case LOAD_NOFILE:
+            printw("@File could not be read!\n");
+            anyKey();
+            return isModified;
+        case LOAD_FORMAT:
+            printw("@Unsupported binary curve file!\n");
+            anyKey();
+            return isModified;
+        case LOAD_CANCELLED:
+            printw("@Load cancelled, partial data freed.\n");
+            anyKey();
+            return isModified;
+        case LOAD_RANGE:
+            printw("@Values do not fit the storage precision!\n");
+            anyKey();
+            return isModified;
+        case LOAD_NOMEMORY:
+            printw("@Not enough memory to load the file!\n");
+            break;
+        case LOAD_SEQUENCE:
+            printw("\t@Values must be sequential!\n\tPlease fix your file!\n");
+            break;
+        default:
+            break;
+    }
+    isModified = true;
+    printw("@Loaded %zu points, %.1f MB in %.3f s (%.1f MB/s)\n",
+        info.points, info.bytes / (1024.0 * 1024.0), info.seconds, loadInfo_Throughput(&info));
+    anyKey();
     return isModified;
 }
 
 bool optionAInput(Curve *curve)
 {
     char userInput;
-    Node *lastNode;
-    Point *newPoint;
-    Point *lastPoint;
-    Point *headPoint;
-    Point *tailPoint;
     double x, y, lastX;
     bool isModified = false;
     bool continueLoop = true;
@@ -595,7 +1128,7 @@ bool optionAInput(Curve *curve)
     while (continueLoop)
     {
         clrscr();
-        coordinatesLoaded(curve->list);
+        coordinatesLoaded(curve);
         printw("\tAdd coordinate? (y/n)\n");
         printw("\tSelection: ");
         refresh();
@@ -604,38 +1137,32 @@ bool optionAInput(Curve *curve)
         {
             case 'Y':
                 isModified = true;
-                lastNode = curve->list->tail_node;
-                if (lastNode != NULL)
+                if (curve->size > 0)
                 {
-                    lastPoint = lastNode->data;
-                    lastX = lastPoint->x;
-                    headPoint = curve->list->head_node->data;
-                    tailPoint = curve->list->tail_node->data;
-                    if (headPoint->x > tailPoint->x)
+                    lastX = curve_GetAt(curve, curve->size - 1).x;
+                    if (curve_GetAt(curve, 0).x > lastX)
                         typeDirection = true;
-                    else if (headPoint->x < tailPoint->x)
+                    else if (curve_GetAt(curve, 0).x < lastX)
                         typeDirection = false;
                 }
                 printw("\tX: ");
                 refresh();
                 scanw(" %lf", &x);
-                if (lastNode != NULL)
+                if (curve->size > 0)
                 {
                     if (x < lastX && typeDirection)
                     {
                         printw("\tY: ");
                         refresh();
                         scanw(" %lf", &y);
-                        newPoint = mkPoint(x, y);
-                        list_Append(curve->list, newPoint);
+                        curve_Append(curve, x, y);
                     }
                     else if (x > lastX && !typeDirection)
                     {
                         printw("\tY: ");
                         refresh();
                         scanw(" %lf", &y);
-                        newPoint = mkPoint(x, y);
-                        list_Append(curve->list, newPoint);
+                        curve_Append(curve, x, y);
                     }
                     else
                     {
@@ -648,8 +1175,7 @@ bool optionAInput(Curve *curve)
                     printw("\tY: ");
                     refresh();
                     scanw(" %lf", &y);
-                    newPoint = mkPoint(x, y);
-                    list_Append(curve->list, newPoint);
+                    curve_Append(curve, x, y);
                 }
                 break;
             case 'N':
@@ -661,4 +1187,42 @@ bool optionAInput(Curve *curve)
     }
     return isModified;
 }
+
+void optionAPrecision()
+{
+    char userInput;
+    double step;
+    clrscr();
+    printw("@Storage precision of new loads (.ncb files stay double):\n");
+    printw("\tA - Double, as read\n");
+    printw("\tB - Float\n");
+    printw("\tC - Fixed point\n");
+    printw("\tSelection: ");
+    refresh();
+    userInput = getLn();
+    switch (userInput)
+    {
+        case 'A':
+            setLoadPrecision(PRECISION_DOUBLE, 0);
+            break;
+        case 'B':
+            setLoadPrecision(PRECISION_FLOAT, 0);
+            break;
+        case 'C':
+            printw("\tStep: ");
+            refresh();
+            if (scanw(" %lf", &step) == 1 && step > 0)
+            {
+                setLoadPrecision(PRECISION_FIXED, step);
+            }
+            else
+            {
+                printw("@Step must be a positive number!\n");
+                anyKey();
+            }
+            break;
+        default:
+            invalidInput();
+    }
+}
 /* endregion */
@@ -0,0 +1,682 @@
+#define _POSIX_C_SOURCE 200809L
+#include "curve.h"
+#include "curveio.h"
+#include "stats.h"
+#include "range.h"
+#include "interp.h"
+#include "simplify.h"
+#include "workspace.h"
+#include "packed.h"
+#include "batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* @brief Options that apply to every batch command
+ * */
+typedef struct
+{
+    /* Save with fsync & atomic rename */
+    bool isDurable;
+    /* Overwrite output files that exist */
+    bool isForced;
+}BatchOptions;
+
+/* @brief A batch command, "--name" followed by argCount arguments
+ * */
+typedef struct
+{
+    const char *name;
+    int argCount;
+    const char *usage;
+    int (*run)(char **args, BatchOptions *options);
+}BatchCommand;
+
+/* region: General functions */
+
+/* @brief Writes a JSON number, non-finite values become null
+ * */
+static void printNumber(double value)
+{
+    char buffer[FORMAT_DOUBLE_SIZE + 1];
+    if (value != value || value - value != 0)
+    {
+        printf("null");
+        return;
+    }
+    buffer[formatDouble(buffer, value)] = '\0';
+    printf("%s", buffer);
+}
+
+/* @brief Writes a JSON string
+ * */
+static void printString(const char *text)
+{
+    putchar('"');
+    for (; *text != '\0'; text++)
+    {
+        if (*text == '"' || *text == '\\')
+            printf("\\%c", *text);
+        else if ((unsigned char) *text < 0x20)
+            printf("\\u%04x", *text);
+        else
+            putchar(*text);
+    }
+    putchar('"');
+}
+
+/* @brief Writes a JSON point object
+ * */
+static void printPoint(Point point)
+{
+    printf("{\"x\":");
+    printNumber(point.x);
+    printf(",\"y\":");
+    printNumber(point.y);
+    printf("}");
+}
+
+/* @brief Writes the fields of curve statistics, the JSON object is left open
+ * @param *fileName File the statistics belong to
+ * @param points Number of points
+ * */
+static void printSummaryFields(const char *fileName, size_t points, double length, double area, Point lowPoint,
+                               Point highPoint)
+{
+    printf("{\"file\":");
+    printString(fileName);
+    printf(",\"points\":%zu,\"length\":", points);
+    printNumber(length);
+    printf(",\"area\":");
+    printNumber(area);
+    printf(",\"low\":");
+    printPoint(lowPoint);
+    printf(",\"high\":");
+    printPoint(highPoint);
+}
+
+/* @brief Writes curve statistics as one JSON line
+ * @param *fileName File the statistics belong to
+ * @param points Number of points
+ * */
+static void printSummary(const char *fileName, size_t points, double length, double area, Point lowPoint, Point highPoint)
+{
+    printSummaryFields(fileName, points, length, area, lowPoint, highPoint);
+    printf("}\n");
+}
+
+/* @brief Writes the statistics of a Curve as one JSON line
+ *
+ * Curves loaded at a lower precision also get the precision & the
+ * bounds of the quantization error.
+ * @param *fileName File the Curve belongs to
+ * @param *curve Target Curve, analyzed first if needed
+ * */
+static void printStats(const char *fileName, Curve *curve)
+{
+    double lengthError, areaError;
+    if (!curve->isAnalyzed)
+        initCurve(curve);
+    printSummaryFields(fileName, curve->size, curve->length, curve->area, curve->lowPoint, curve->highPoint);
+    if (curve->precision != PRECISION_DOUBLE)
+    {
+        curve_ErrorBounds(curve, &lengthError, &areaError);
+        printf(",\"precision\":");
+        printString(precisionName(curve->precision));
+        if (curve->precision == PRECISION_FIXED)
+        {
+            printf(",\"step\":");
+            printNumber(curve->precisionStep);
+        }
+        printf(",\"error\":{\"x\":");
+        printNumber(curve->errorX);
+        printf(",\"y\":");
+        printNumber(curve->errorY);
+        printf(",\"length\":");
+        printNumber(lengthError);
+        printf(",\"area\":");
+        printNumber(areaError);
+        printf("}");
+    }
+    printf("}\n");
+}
+
+/* @brief Parses a whole argument as a number
+ * @return Returns false if the argument is not a number
+ * */
+static bool parseArgument(const char *argument, double *value)
+{
+    const char *end = argument + strlen(argument);
+    return *argument != '\0' && parseDouble(argument, end, value) == end;
+}
+
+/* @brief Converts a load status to an exit code, reporting failures on stderr
+ * @return BATCH_OK or an error code
+ * */
+static int loadResult(LoadStatus status, const char *fileName)
+{
+    switch (status)
+    {
+        case LOAD_OK:
+            return BATCH_OK;
+        case LOAD_NOFILE:
+            fprintf(stderr, "NCurveCalc: %s: file could not be read\n", fileName);
+            return BATCH_EFILE;
+        case LOAD_NOMEMORY:
+            fprintf(stderr, "NCurveCalc: %s: not enough memory\n", fileName);
+            return BATCH_EMEMORY;
+        case LOAD_SEQUENCE:
+            fprintf(stderr, "NCurveCalc: %s: values must be sequential\n", fileName);
+            return BATCH_EDATA;
+        case LOAD_CANCELLED:
+            fprintf(stderr, "NCurveCalc: %s: load cancelled\n", fileName);
+            return BATCH_EFILE;
+        case LOAD_RANGE:
+            fprintf(stderr, "NCurveCalc: %s: values do not fit the precision\n", fileName);
+            return BATCH_EDATA;
+        case LOAD_FORMAT:
+        default:
+            fprintf(stderr, "NCurveCalc: %s: unsupported binary curve file\n", fileName);
+            return BATCH_EDATA;
+    }
+}
+
+/* @brief Loads a curve file, reporting failures on stderr
+ * @return BATCH_OK or an error code
+ * */
+static int loadInput(Curve *curve, const char *fileName)
+{
+    return loadResult(curve_LoadFile(curve, fileName, NULL), fileName);
+}
+
+/* @brief Checks that an output file may be written, reporting on stderr
+ * @return BATCH_OK or an error code
+ * */
+static int checkOutput(const char *fileName, BatchOptions *options)
+{
+    struct stat fileTest;
+    if (!options->isForced && stat(fileName, &fileTest) == 0)
+    {
+        fprintf(stderr, "NCurveCalc: %s: file exists, use --force to overwrite\n", fileName);
+        return BATCH_EFILE;
+    }
+    return BATCH_OK;
+}
+
+/* @brief Saves a curve file, text or binary by extension
+ * @return BATCH_OK or an error code
+ * */
+static int saveOutput(Curve *curve, const char *fileName, BatchOptions *options)
+{
+    bool isSaved;
+    if (checkOutput(fileName, options) != BATCH_OK)
+        return BATCH_EFILE;
+    if (isBinaryName(fileName))
+        isSaved = curve_SaveBinary(curve, fileName, options->isDurable);
+    else
+        isSaved = curve_SaveText(curve, fileName, options->isDurable);
+    if (!isSaved)
+    {
+        fprintf(stderr, "NCurveCalc: %s: file could not be written\n", fileName);
+        return BATCH_EFILE;
+    }
+    return BATCH_OK;
+}
+
+/* @brief Parses numeric command arguments, reporting failures on stderr
+ * @return Returns false if an argument is not a number
+ * */
+static bool parseNumbers(char **args, double *values, int count)
+{
+    int loopVar;
+    for (loopVar = 0; loopVar < count; loopVar++)
+    {
+        if (!parseArgument(args[loopVar], &values[loopVar]))
+        {
+            fprintf(stderr, "NCurveCalc: %s: not a number\n", args[loopVar]);
+            return false;
+        }
+    }
+    return true;
+}
+/* endregion */
+
+/* region: Commands */
+
+/* @brief --stats IN
+ * */
+static int commandStats(char **args, BatchOptions *options)
+{
+    Curve *curve = mkCurve();
+    int result = loadInput(curve, args[0]);
+    (void) options;
+    if (result == BATCH_OK)
+        printStats(args[0], curve);
+    rmCurve(curve);
+    return result;
+}
+
+/* @brief --stream IN, IN of "-" reads stdin
+ *
+ * Statistics are gathered while reading, so input of any size can be
+ * piped through in constant memory.
+ * */
+static int commandStream(char **args, BatchOptions *options)
+{
+    StreamStats stats;
+    int fd = STDIN_FILENO;
+    int result;
+    (void) options;
+    if (strcmp(args[0], "-") != 0)
+        fd = open(args[0], O_RDONLY);
+    if (fd < 0)
+        return loadResult(LOAD_NOFILE, args[0]);
+    streamStats_Init(&stats);
+    result = loadResult(streamStats_Read(&stats, fd, NULL), args[0]);
+    if (fd != STDIN_FILENO)
+        close(fd);
+    if (result == BATCH_OK)
+        printSummary(args[0], stats.count, stats.length, stats.area, stats.lowPoint, stats.highPoint);
+    return result;
+}
+
+/* @brief --range FROM TO IN
+ * */
+static int commandRange(char **args, BatchOptions *options)
+{
+    Curve *curve;
+    double values[2];
+    double length, area;
+    int result;
+    (void) options;
+    if (!parseNumbers(args, values, 2))
+        return BATCH_EUSAGE;
+    curve = mkCurve();
+    result = loadInput(curve, args[2]);
+    if (result == BATCH_OK && !curve_RangeStats(curve, values[0], values[1], &length, &area))
+    {
+        fprintf(stderr, "NCurveCalc: %s: not enough memory\n", args[2]);
+        result = BATCH_EMEMORY;
+    }
+    if (result == BATCH_OK)
+    {
+        printf("{\"file\":");
+        printString(args[2]);
+        printf(",\"from\":");
+        printNumber(values[0]);
+        printf(",\"to\":");
+        printNumber(values[1]);
+        printf(",\"length\":");
+        printNumber(length);
+        printf(",\"area\":");
+        printNumber(area);
+        printf("}\n");
+    }
+    rmCurve(curve);
+    return result;
+}
+
+/* @brief --interpolate QUERIES IN, QUERIES of "-" reads stdin
+ *
+ * Writes one "x y" line per query x, y is nan outside the curve.
+ * */
+static int commandInterpolate(char **args, BatchOptions *options)
+{
+    Curve *curve;
+    char line[2 * FORMAT_DOUBLE_SIZE + 2];
+    char *out;
+    double *queries = NULL;
+    double *results = NULL;
+    size_t count = 0;
+    size_t index;
+    int fd = STDIN_FILENO;
+    int result;
+    (void) options;
+    curve = mkCurve();
+    result = loadInput(curve, args[1]);
+    if (result == BATCH_OK)
+    {
+        if (strcmp(args[0], "-") != 0)
+            fd = open(args[0], O_RDONLY);
+        if (fd < 0)
+            result = loadResult(LOAD_NOFILE, args[0]);
+    }
+    if (result == BATCH_OK)
+    {
+        result = loadResult(readNumbers(fd, &queries, &count), args[0]);
+        if (fd != STDIN_FILENO)
+            close(fd);
+    }
+    if (result == BATCH_OK && count > 0)
+    {
+        results = (double *) malloc(count * sizeof(double));
+        if (results == NULL)
+            result = loadResult(LOAD_NOMEMORY, args[0]);
+    }
+    if (result == BATCH_OK)
+    {
+        curve_Interpolate(curve, queries, count, results);
+        for (index = 0; index < count; index++)
+        {
+            out = line;
+            out += formatDouble(out, queries[index]);
+            *out++ = ' ';
+            out += formatDouble(out, results[index]);
+            *out++ = '\n';
+            fwrite(line, 1, out - line, stdout);
+        }
+    }
+    free(queries);
+    free(results);
+    rmCurve(curve);
+    return result;
+}
+
+/* @brief --simplify TOLERANCE IN OUT
+ * */
+static int commandSimplify(char **args, BatchOptions *options)
+{
+    Curve *curve;
+    SimplifyInfo info;
+    double tolerance;
+    int result;
+    if (!parseNumbers(args, &tolerance, 1))
+        return BATCH_EUSAGE;
+    curve = mkCurve();
+    result = loadInput(curve, args[1]);
+    if (result == BATCH_OK && !curve_Simplify(curve, tolerance, &info))
+        result = loadResult(LOAD_NOMEMORY, args[1]);
+    if (result == BATCH_OK)
+        result = saveOutput(curve, args[2], options);
+    if (result == BATCH_OK)
+    {
+        printf("{\"file\":");
+        printString(args[2]);
+        printf(",\"points\":%zu,\"removed\":%zu,\"freed_bytes\":%zu,\"length\":", curve->size, info.removed,
+               info.freedBytes);
+        printNumber(info.lengthAfter);
+        printf(",\"length_error\":");
+        printNumber(info.lengthAfter - info.lengthBefore);
+        printf(",\"area\":");
+        printNumber(info.areaAfter);
+        printf(",\"area_error\":");
+        printNumber(info.areaAfter - info.areaBefore);
+        printf("}\n");
+    }
+    rmCurve(curve);
+    return result;
+}
+
+/* @brief --shift DX DY IN OUT & --scale SX SY IN OUT
+ * */
+static int transformFile(char **args, BatchOptions *options, bool isShift)
+{
+    Curve *curve;
+    double values[2];
+    int result;
+    if (!parseNumbers(args, values, 2))
+        return BATCH_EUSAGE;
+    curve = mkCurve();
+    result = loadInput(curve, args[2]);
+    if (result == BATCH_OK)
+    {
+        if (isShift)
+            mvCurve(curve, values[0], values[1]);
+        else
+            curve_Transform(curve, values[0], values[1], 0, 0);
+        result = saveOutput(curve, args[3], options);
+    }
+    if (result == BATCH_OK)
+        printStats(args[3], curve);
+    rmCurve(curve);
+    return result;
+}
+
+static int commandShift(char **args, BatchOptions *options)
+{
+    return transformFile(args, options, true);
+}
+
+static int commandScale(char **args, BatchOptions *options)
+{
+    return transformFile(args, options, false);
+}
+
+/* @brief --convert IN OUT
+ * */
+static int commandConvert(char **args, BatchOptions *options)
+{
+    Curve *curve = mkCurve();
+    int result = loadInput(curve, args[0]);
+    if (result == BATCH_OK)
+        result = saveOutput(curve, args[1], options);
+    if (result == BATCH_OK)
+        printStats(args[1], curve);
+    rmCurve(curve);
+    return result;
+}
+
+/* @brief --pack IN OUT
+ *
+ * Compresses IN, frees its arrays, then analyzes & saves OUT from the
+ * compressed blocks. Prints the statistics with the memory held by the
+ * points before & after.
+ * */
+static int commandPack(char **args, BatchOptions *options)
+{
+    Curve *curve = mkCurve();
+    PackedCurve *packed = NULL;
+    size_t bytes;
+    bool isSaved;
+    int result = loadInput(curve, args[0]);
+    if (result == BATCH_OK)
+        result = checkOutput(args[1], options);
+    if (result == BATCH_OK)
+    {
+        bytes = curve_Bytes(curve);
+        packed = mkPackedCurve(curve);
+        if (packed == NULL)
+        {
+            fprintf(stderr, "NCurveCalc: not enough memory\n");
+            result = BATCH_EMEMORY;
+        }
+    }
+    if (result == BATCH_OK)
+    {
+        curve_Clear(curve);
+        packedCurve_Analyze(packed);
+        if (isBinaryName(args[1]))
+            isSaved = packedCurve_SaveBinary(packed, args[1], options->isDurable);
+        else
+            isSaved = packedCurve_SaveText(packed, args[1], options->isDurable);
+        if (!isSaved)
+        {
+            fprintf(stderr, "NCurveCalc: %s: file could not be written\n", args[1]);
+            result = BATCH_EFILE;
+        }
+    }
+    if (result == BATCH_OK)
+    {
+        printf("{\"file\":");
+        printString(args[1]);
+        printf(",\"points\":%zu,\"bytes\":%zu,\"packed_bytes\":%zu,\"length\":", packed->count, bytes,
+               packedCurve_Bytes(packed));
+        printNumber(packed->length);
+        printf(",\"area\":");
+        printNumber(packed->area);
+        printf(",\"low\":");
+        printPoint(packed->lowPoint);
+        printf(",\"high\":");
+        printPoint(packed->highPoint);
+        printf("}\n");
+    }
+    rmPackedCurve(packed);
+    rmCurve(curve);
+    return result;
+}
+
+/* @brief --summary DIR
+ * */
+static int commandSummary(char **args, BatchOptions *options)
+{
+    Workspace *workspace = mkWorkspace(0);
+    WorkspaceEntry *entry;
+    size_t index;
+    int status, result = BATCH_OK;
+    (void) options;
+    if (workspace == NULL)
+    {
+        fprintf(stderr, "NCurveCalc: not enough memory\n");
+        return BATCH_EMEMORY;
+    }
+    if (workspace_AddDirectory(workspace, args[0]) < 0)
+    {
+        fprintf(stderr, "NCurveCalc: %s: directory could not be read\n", args[0]);
+        rmWorkspace(workspace);
+        return BATCH_EFILE;
+    }
+    workspace_Load(workspace);
+    workspace_Analyze(workspace);
+    /* Failures are reported per file, the last one sets the exit code */
+    for (index = 0; index < workspace->count; index++)
+    {
+        entry = &workspace->entries[index];
+        status = loadResult(entry->status, entry->fileName);
+        if (status == BATCH_OK)
+            printStats(entry->fileName, entry->curve);
+        else
+            result = status;
+    }
+    rmWorkspace(workspace);
+    return result;
+}
+
+static const BatchCommand commands[] =
+{
+    {"--stats", 1, "--stats IN", commandStats},
+    {"--stream", 1, "--stream IN", commandStream},
+    {"--range", 3, "--range FROM TO IN", commandRange},
+    {"--interpolate", 2, "--interpolate QUERIES IN", commandInterpolate},
+    {"--shift", 4, "--shift DX DY IN OUT", commandShift},
+    {"--scale", 4, "--scale SX SY IN OUT", commandScale},
+    {"--simplify", 3, "--simplify TOLERANCE IN OUT", commandSimplify},
+    {"--convert", 2, "--convert IN OUT", commandConvert},
+    {"--pack", 2, "--pack IN OUT", commandPack},
+    {"--summary", 1, "--summary DIR", commandSummary}
+};
+/* endregion */
+
+/* @brief Prints batch mode usage
+ * */
+static void printUsage(FILE *output)
+{
+    size_t loopVar;
+    fprintf(output, "Usage: NCurveCalc [options] COMMAND\n");
+    fprintf(output, "Without a command NCurveCalc starts the interactive menus.\n\n");
+    fprintf(output, "Commands, OUT ending in .ncb is saved as a binary curve:\n");
+    fprintf(output, "(--stream reads text from a file, pipe or - for stdin in constant memory)\n");
+    fprintf(output, "(--interpolate reads x values from QUERIES, - for stdin)\n");
+    fprintf(output, "(--summary loads every file of DIR in parallel)\n");
+    for (loopVar = 0; loopVar < sizeof(commands) / sizeof(commands[0]); loopVar++)
+        fprintf(output, "  %s\n", commands[loopVar].usage);
+    fprintf(output, "\nOptions:\n");
+    fprintf(output, "  --threads N  Threads used for statistics, --summary & text loads\n");
+    fprintf(output, "  --budget MB  Memory used at a time by passes over .ncb files\n");
+    fprintf(output, "  --precision P\n");
+    fprintf(output, "               Store loaded points as double, float or multiples of P\n");
+    fprintf(output, "               (.ncb files are mapped as doubles and keep them)\n");
+    fprintf(output, "  --durable    Sync saved files and rename them into place\n");
+    fprintf(output, "  --force      Overwrite output files\n");
+    fprintf(output, "  --help       Show this help\n");
+}
+
+bool isBatchMode(int argc, char **argv)
+{
+    (void) argv;
+    return argc > 1;
+}
+
+int batchMain(int argc, char **argv)
+{
+    BatchOptions options;
+    CurvePrecision precision;
+    double threads, budget, step;
+    size_t loopVar;
+    int argIndex = 1;
+    options.isDurable = false;
+    options.isForced = false;
+    while (argIndex < argc)
+    {
+        if (strcmp(argv[argIndex], "--help") == 0)
+        {
+            printUsage(stdout);
+            return BATCH_OK;
+        }
+        else if (strcmp(argv[argIndex], "--durable") == 0)
+        {
+            options.isDurable = true;
+        }
+        else if (strcmp(argv[argIndex], "--force") == 0)
+        {
+            options.isForced = true;
+        }
+        else if (strcmp(argv[argIndex], "--threads") == 0)
+        {
+            if (argIndex + 1 >= argc || !parseArgument(argv[argIndex + 1], &threads) || threads < 1)
+            {
+                fprintf(stderr, "NCurveCalc: --threads needs a positive number\n");
+                return BATCH_EUSAGE;
+            }
+            setStatsThreads((int) threads);
+            argIndex++;
+        }
+        else if (strcmp(argv[argIndex], "--budget") == 0)
+        {
+            if (argIndex + 1 >= argc || !parseArgument(argv[argIndex + 1], &budget) || budget < 1)
+            {
+                fprintf(stderr, "NCurveCalc: --budget needs a positive number of megabytes\n");
+                return BATCH_EUSAGE;
+            }
+            setMemoryBudget((size_t) (budget * 1024 * 1024));
+            argIndex++;
+        }
+        else if (strcmp(argv[argIndex], "--precision") == 0)
+        {
+            if (argIndex + 1 >= argc || !parsePrecision(argv[argIndex + 1], &precision, &step))
+            {
+                fprintf(stderr, "NCurveCalc: --precision needs double, float or a positive step\n");
+                return BATCH_EUSAGE;
+            }
+            setLoadPrecision(precision, step);
+            argIndex++;
+        }
+        else
+        {
+            break;
+        }
+        argIndex++;
+    }
+    if (argIndex >= argc)
+    {
+        printUsage(stderr);
+        return BATCH_EUSAGE;
+    }
+    for (loopVar = 0; loopVar < sizeof(commands) / sizeof(commands[0]); loopVar++)
+    {
+        if (strcmp(argv[argIndex], commands[loopVar].name) != 0)
+            continue;
+        if (argc - argIndex - 1 != commands[loopVar].argCount)
+        {
+            fprintf(stderr, "Usage: NCurveCalc [options] %s\n", commands[loopVar].usage);
+            return BATCH_EUSAGE;
+        }
+        return commands[loopVar].run(argv + argIndex + 1, &options);
+    }
+    fprintf(stderr, "NCurveCalc: unknown command %s\n", argv[argIndex]);
+    printUsage(stderr);
+    return BATCH_EUSAGE;
+}
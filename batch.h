@@ -0,0 +1,31 @@
+#ifndef BATCH_H
+    #define BATCH_H
+#include <stdbool.h>
+
+/* Exit codes of batch mode */
+#define BATCH_OK 0
+/* Bad command line */
+#define BATCH_EUSAGE 1
+/* File could not be read or written */
+#define BATCH_EFILE 2
+/* File holds data that is not a valid curve */
+#define BATCH_EDATA 3
+/* Out of memory */
+#define BATCH_EMEMORY 4
+
+/* @brief Checks if the command line asks for batch mode
+ * @param argc Argument count from main
+ * @param **argv Arguments from main
+ * @return Returns true if NCurveCalc should run without curses
+ * */
+bool isBatchMode(int argc, char **argv);
+
+/* @brief Runs one batch command without curses
+ *
+ * Results are written to stdout as JSON, errors to stderr.
+ * @param argc Argument count from main
+ * @param **argv Arguments from main
+ * @return Process exit code, one of the BATCH_ codes
+ * */
+int batchMain(int argc, char **argv);
+#endif
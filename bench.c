@@ -0,0 +1,342 @@
+#define _POSIX_C_SOURCE 200809L
+#include "clist.h"
+#include "curve.h"
+#include "curveio.h"
+#include "interp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/* Smallest curve measured, sizes grow by 10 up to the requested largest */
+#define BENCH_MIN_POINTS 1000
+/* Largest curve measured when no size is given */
+#define BENCH_DEFAULT_POINTS 1000000
+/* Indices read from the start of the List by the sequential pattern */
+#define BENCH_SEQUENTIAL_READS 4096
+/* Upper bound on List items walked by the random pattern */
+#define BENCH_RANDOM_STEPS ((size_t) 1 << 27)
+/* Most indices read by the random pattern */
+#define BENCH_RANDOM_READS 1024
+
+/* @brief Timing of one hot path
+ * */
+typedef struct
+{
+    const char *name;
+    double seconds;
+    /* Operations timed, points for whole curve paths */
+    size_t operations;
+}BenchPhase;
+
+/* @brief Results of one curve size & direction
+ * */
+typedef struct
+{
+    size_t points;
+    bool isDescending;
+    BenchPhase phases[16];
+    int phaseCount;
+    size_t textBytes;
+    long peakKilobytes;
+}BenchCase;
+
+/* @brief Gets a monotonic time stamp
+ * @return Seconds since an unspecified point
+ * */
+static double nowSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* @brief Records a timed phase
+ * */
+static void bench_Add(BenchCase *bench, const char *name, double startTime, size_t operations)
+{
+    BenchPhase *phase = &bench->phases[bench->phaseCount++];
+    phase->name = name;
+    phase->seconds = nowSeconds() - startTime;
+    phase->operations = operations;
+}
+
+/* @brief Fills a Curve with a synthetic monotonic curve
+ *
+ * X steps by a small varying amount so text files hold realistic digits,
+ * y is a mix of sines so the statistics touch every point.
+ * @param *curve Target Curve, cleared first
+ * @param points Number of points
+ * @param isDescending True for shrinking x values
+ * @return Returns false if memory could not be allocated
+ * */
+static bool makeCurve(Curve *curve, size_t points, bool isDescending)
+{
+    size_t index;
+    double x = 0;
+    double y;
+    curve_Clear(curve);
+    if (!curve_Reserve(curve, points))
+        return false;
+    for (index = 0; index < points; index++)
+    {
+        x += 0.25 + 0.125 * sin(index * 0.001);
+        y = 100 * sin(index * 1e-4) + 3 * sin(index * 0.37);
+        if (!curve_Append(curve, isDescending ? -x : x, y))
+            return false;
+    }
+    return true;
+}
+
+/* @brief Gets the size of a file
+ * @return Bytes in the file, 0 if it does not exist
+ * */
+static size_t fileSize(const char *fileName)
+{
+    struct stat fileStat;
+    if (stat(fileName, &fileStat) != 0)
+        return 0;
+    return fileStat.st_size;
+}
+
+/* @brief Times every hot path on one curve size & direction
+ * @param *bench Results, points & isDescending set
+ * @param *directory Directory for the temporary curve files
+ * @return Returns false if a step failed
+ * */
+static bool runCase(BenchCase *bench, const char *directory)
+{
+    char textName[4096];
+    char binaryName[4096];
+    struct rusage usage;
+    Curve *curve = mkCurve();
+    List *list;
+    double *queries = NULL;
+    double *results = NULL;
+    Point first, last;
+    volatile double sink = 0;
+    double startTime;
+    size_t points = bench->points;
+    size_t reads, index, loopVar;
+    bool isOk = false;
+    snprintf(textName, sizeof(textName), "%s/ncurve-bench-%ld.txt", directory, (long) getpid());
+    snprintf(binaryName, sizeof(binaryName), "%s/ncurve-bench-%ld.ncb", directory, (long) getpid());
+    bench->phaseCount = 0;
+    if (curve == NULL || !makeCurve(curve, points, bench->isDescending))
+        goto done;
+
+    startTime = nowSeconds();
+    if (!curve_SaveText(curve, textName, false))
+        goto done;
+    bench_Add(bench, "save_text", startTime, points);
+    bench->textBytes = fileSize(textName);
+
+    startTime = nowSeconds();
+    if (!curve_SaveBinary(curve, binaryName, false))
+        goto done;
+    bench_Add(bench, "save_binary", startTime, points);
+
+    curve_Clear(curve);
+    startTime = nowSeconds();
+    if (curve_LoadFile(curve, textName, NULL) != LOAD_OK || curve->size != points)
+        goto done;
+    bench_Add(bench, "load_text", startTime, points);
+
+    curve->isAnalyzed = false;
+    startTime = nowSeconds();
+    initCurve(curve);
+    bench_Add(bench, "init_curve", startTime, points);
+
+    startTime = nowSeconds();
+    mvCurve(curve, 1.5, -2.5);
+    bench_Add(bench, "mv_curve", startTime, points);
+
+    startTime = nowSeconds();
+    curve_Commit(curve);
+    bench_Add(bench, "commit", startTime, points);
+
+    startTime = nowSeconds();
+    for (index = 0; index < points; index++)
+        sink += curve_GetAt(curve, index).y;
+    bench_Add(bench, "curve_get_at", startTime, points);
+
+    /* One query per point, spread over the whole curve */
+    queries = (double *) malloc(points * sizeof(double));
+    results = (double *) malloc(points * sizeof(double));
+    if (queries == NULL || results == NULL)
+        goto done;
+    first = curve_GetAt(curve, 0);
+    last = curve_GetAt(curve, points - 1);
+    for (index = 0; index < points; index++)
+        queries[index] = first.x + (last.x - first.x) * index / points;
+    startTime = nowSeconds();
+    curve_Interpolate(curve, queries, points, results);
+    bench_Add(bench, "interpolate_sorted", startTime, points);
+    srand(1);
+    for (index = 0; index < points; index++)
+        queries[index] = first.x + (last.x - first.x) * (rand() / (double) RAND_MAX);
+    startTime = nowSeconds();
+    curve_Interpolate(curve, queries, points, results);
+    bench_Add(bench, "interpolate_random", startTime, points);
+    free(queries);
+    free(results);
+    queries = NULL;
+    results = NULL;
+
+    startTime = nowSeconds();
+    list = curve_ToList(curve);
+    if (list == NULL)
+        goto done;
+    bench_Add(bench, "to_list", startTime, points);
+
+    /* Random list_GetAt calls walk the List, so only a bounded number of
+     * indices are read to keep the largest curves measurable */
+    reads = points < BENCH_SEQUENTIAL_READS ? points : BENCH_SEQUENTIAL_READS;
+    startTime = nowSeconds();
+    for (index = 0; index < reads; index++)
+        sink += ((Point *) list_GetAt(list, (int) index))->y;
+    bench_Add(bench, "list_get_at_sequential", startTime, reads);
+
+    reads = BENCH_RANDOM_STEPS / points;
+    if (reads > BENCH_RANDOM_READS)
+        reads = BENCH_RANDOM_READS;
+    if (reads == 0)
+        reads = 1;
+    srand(1);
+    startTime = nowSeconds();
+    for (loopVar = 0; loopVar < reads; loopVar++)
+    {
+        index = ((size_t) rand() * ((size_t) RAND_MAX + 1) + rand()) % points;
+        sink += ((Point *) list_GetAt(list, (int) index))->y;
+    }
+    bench_Add(bench, "list_get_at_random", startTime, reads);
+
+    startTime = nowSeconds();
+    rmList(list);
+    bench_Add(bench, "rm_list", startTime, points);
+
+    startTime = nowSeconds();
+    curve_Clear(curve);
+    bench_Add(bench, "clear_curve", startTime, points);
+
+    startTime = nowSeconds();
+    if (curve_LoadFile(curve, binaryName, NULL) != LOAD_OK || curve->size != points)
+        goto done;
+    bench_Add(bench, "load_binary", startTime, points);
+    isOk = true;
+done:
+    free(queries);
+    free(results);
+    rmCurve(curve);
+    remove(textName);
+    remove(binaryName);
+    getrusage(RUSAGE_SELF, &usage);
+    bench->peakKilobytes = usage.ru_maxrss;
+    return isOk;
+}
+
+/* @brief Writes the results of one case as a JSON object
+ * */
+static void printJson(FILE *output, BenchCase *bench)
+{
+    int loopVar;
+    BenchPhase *phase;
+    fprintf(output, "  {\"points\": %zu, \"direction\": \"%s\", \"text_bytes\": %zu, \"peak_rss_kb\": %ld, \"phases\": {",
+            bench->points, bench->isDescending ? "descending" : "ascending", bench->textBytes, bench->peakKilobytes);
+    for (loopVar = 0; loopVar < bench->phaseCount; loopVar++)
+    {
+        phase = &bench->phases[loopVar];
+        fprintf(output, "%s\"%s\": {\"seconds\": %.9f, \"operations\": %zu, \"ns_per_op\": %.3f}",
+                loopVar > 0 ? ", " : "", phase->name, phase->seconds, phase->operations,
+                phase->seconds * 1e9 / phase->operations);
+    }
+    fprintf(output, "}}");
+}
+
+/* @brief Writes the results of one case as table rows
+ * */
+static void printTable(BenchCase *bench)
+{
+    int loopVar;
+    BenchPhase *phase;
+    printf("%zu points, %s, peak RSS %ld KB\n", bench->points,
+           bench->isDescending ? "descending" : "ascending", bench->peakKilobytes);
+    for (loopVar = 0; loopVar < bench->phaseCount; loopVar++)
+    {
+        phase = &bench->phases[loopVar];
+        printf("  %-24s %12.6f s %12.3f ns/op\n", phase->name, phase->seconds,
+               phase->seconds * 1e9 / phase->operations);
+    }
+    fflush(stdout);
+}
+
+/* Usage: NCurveBench [largest points] [json file]
+ *
+ * Each case runs in its own process so its peak RSS is its own, temporary
+ * files go to $TMPDIR or /tmp.
+ * */
+int main(int argc, char **argv)
+{
+    BenchCase bench;
+    FILE *output = stdout;
+    const char *directory = getenv("TMPDIR");
+    size_t largest = BENCH_DEFAULT_POINTS;
+    size_t points;
+    int direction, status;
+    int failures = 0;
+    bool isFirst = true;
+    pid_t child;
+    if (argc > 1)
+        largest = (size_t) strtod(argv[1], NULL);
+    if (largest < BENCH_MIN_POINTS)
+        largest = BENCH_MIN_POINTS;
+    if (directory == NULL || *directory == '\0')
+        directory = "/tmp";
+    if (argc > 2 && (output = fopen(argv[2], "w")) == NULL)
+    {
+        fprintf(stderr, "NCurveBench: %s: file could not be written\n", argv[2]);
+        return 1;
+    }
+    fprintf(output, "[\n");
+    for (points = BENCH_MIN_POINTS; points <= largest; points *= 10)
+    {
+        for (direction = 0; direction < 2; direction++)
+        {
+            bench.points = points;
+            bench.isDescending = direction == 1;
+            fflush(stdout);
+            fflush(output);
+            child = fork();
+            if (child == 0)
+            {
+                if (!runCase(&bench, directory))
+                    _exit(1);
+                if (output != stdout)
+                    printTable(&bench);
+                fprintf(output, "%s", isFirst ? "" : ",\n");
+                printJson(output, &bench);
+                fflush(output);
+                _exit(0);
+            }
+            if (child < 0 || waitpid(child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                fprintf(stderr, "NCurveBench: %zu points %s failed\n", points,
+                        bench.isDescending ? "descending" : "ascending");
+                failures++;
+                continue;
+            }
+            isFirst = false;
+        }
+    }
+    fprintf(output, "\n]\n");
+    if (output != stdout)
+        fclose(output);
+    return failures > 0;
+}
@@ -0,0 +1,149 @@
+#define _POSIX_C_SOURCE 200809L
+#include "curve.h"
+#include "packed.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+/* Every size up to this many points is packed, crossing the word
+ * boundaries of each column encoding */
+#define CHECK_ALL_SIZES 2100
+/* Sizes around the block boundaries are packed up to this many blocks */
+#define CHECK_BLOCKS 6
+
+/* @brief Kinds of coordinates packed, one per column encoding
+ * */
+typedef enum
+{
+    CHECK_RANDOM,
+    CHECK_DECIMAL,
+    CHECK_FLOAT,
+    CHECK_FIXED,
+    CHECK_CONSTANT,
+    CHECK_KIND_COUNT
+}CheckKind;
+
+static const char *kindNames[CHECK_KIND_COUNT] =
+{
+    "random", "decimal", "float", "fixed", "constant"
+};
+
+/* @brief Gets a random double from 0 to 1 with all 53 bits set
+ * */
+static double randomUnit()
+{
+    uint64_t bits = ((uint64_t) rand() << 31) ^ ((uint64_t) rand() << 11) ^ (uint64_t) rand();
+    return (bits & (((uint64_t) 1 << 53) - 1)) / 9007199254740992.0;
+}
+
+/* @brief Fills a Curve with points of one kind
+ * @param *curve Target Curve, cleared first
+ * @param points Number of points
+ * @param kind Kind of coordinates
+ * @return Returns false if memory could not be allocated
+ * */
+static bool makeCurve(Curve *curve, size_t points, CheckKind kind)
+{
+    size_t index;
+    double x = 0;
+    double y;
+    curve_Clear(curve);
+    for (index = 0; index < points; index++)
+    {
+        x += randomUnit();
+        switch (kind)
+        {
+            case CHECK_RANDOM:
+                y = randomUnit();
+                break;
+            case CHECK_DECIMAL:
+                x = round(x * 1000) / 1000;
+                y = round((randomUnit() - 0.5) * 1e5) / 1000;
+                break;
+            case CHECK_FLOAT:
+                x = (float) x;
+                y = (float) ((randomUnit() - 0.5) * 100);
+                break;
+            case CHECK_FIXED:
+                x = round(x * 64) / 64;
+                y = round((randomUnit() - 0.5) * 1e4) / 64;
+                break;
+            default:
+                y = 42.5;
+        }
+        if (!curve_Append(curve, x, y))
+            return false;
+    }
+    return true;
+}
+
+/* @brief Packs & unpacks a Curve and compares every coordinate bit for bit
+ * @return Returns false if the points differ or memory ran out
+ * */
+static bool roundTrip(Curve *curve, Curve *unpacked)
+{
+    PackedCurve *packed = mkPackedCurve(curve);
+    Point point, other;
+    size_t index;
+    bool isSame;
+    if (packed == NULL)
+        return false;
+    isSame = packedCurve_Unpack(packed, unpacked) && unpacked->size == curve->size;
+    for (index = 0; index < curve->size && isSame; index++)
+    {
+        point = curve_GetAt(curve, index);
+        other = curve_GetAt(unpacked, index);
+        isSame = memcmp(&point.x, &other.x, sizeof(double)) == 0
+              && memcmp(&point.y, &other.y, sizeof(double)) == 0;
+    }
+    rmPackedCurve(packed);
+    return isSame;
+}
+
+/* Usage: NCurveCheck
+ *
+ * Round trips curves of every column encoding through PackedCurve over
+ * sizes crossing the word & block boundaries, exits 1 on a mismatch.
+ * */
+int main()
+{
+    Curve *curve = mkCurve();
+    Curve *unpacked = mkCurve();
+    size_t sizes[CHECK_ALL_SIZES + 5 * CHECK_BLOCKS];
+    size_t sizeCount = 0;
+    size_t points, block, loopVar;
+    int kind, delta;
+    int failures = 0;
+    int checks = 0;
+    if (curve == NULL || unpacked == NULL)
+        return 1;
+    for (points = 0; points <= CHECK_ALL_SIZES; points++)
+        sizes[sizeCount++] = points;
+    for (block = 3; block <= CHECK_BLOCKS; block++)
+    {
+        for (delta = -2; delta <= 2; delta++)
+            sizes[sizeCount++] = block * PACKED_BLOCK_POINTS + delta;
+    }
+    srand(1);
+    for (kind = 0; kind < CHECK_KIND_COUNT; kind++)
+    {
+        for (loopVar = 0; loopVar < sizeCount; loopVar++)
+        {
+            points = sizes[loopVar];
+            checks++;
+            if (!makeCurve(curve, points, (CheckKind) kind) || !roundTrip(curve, unpacked))
+            {
+                fprintf(stderr, "NCurveCheck: %s curve of %zu points does not round trip\n",
+                        kindNames[kind], points);
+                failures++;
+            }
+        }
+    }
+    printf("%d of %d packed curves round trip\n", checks - failures, checks);
+    rmCurve(curve);
+    rmCurve(unpacked);
+    return failures > 0;
+}
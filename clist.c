@@ -16,251 +16,347 @@
  * */
 
 #include "clist.h"
+#include "perf.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
-/* List & Node structure definitions. 
+/* List & Chunk structure definitions. 
  *
  *typedef struct
  *{
- *    void *data;
- *    Node *next_node;
- *} Node;
+ *    Chunk *next_chunk;
+ *    Chunk *prev_chunk;
+ *    int count;
+ *    void *data[LIST_CHUNK_SIZE];
+ *} Chunk;
  *
  *typedef struct
  *{
- *    Node *head_node;
- *    Node *tail_node;
+ *    Chunk *head_chunk;
+ *    Chunk *tail_chunk;
  *    int size;
+ *    Pool *pool;
+ *    Chunk *cursor_chunk;
+ *    int cursor_index;
  *} List;
  *
  **/
 
-/*Node specific functions*/
-Node *mkNode(void *data, Node *next_node)
+/* Default bytes per slab, large enough to amortize one malloc over
+ * thousands of Chunks or tens of thousands of Points */
+#define POOL_SLAB_SIZE (1 << 20)
+/* Alignment of every pool allocation */
+#define POOL_ALIGN 16
+
+/*Pool specific functions*/
+Pool *mkPool(size_t slab_size)
 {
-    Node *node = (Node *) malloc(sizeof(Node));
-    if (node != NULL)
+    Pool *pool = (Pool *) malloc(sizeof(Pool));
+    if (pool != NULL)
     {
-        node->data = data;
-        node->next_node = next_node;
+        pool->head_slab = NULL;
+        pool->slab_size = slab_size > 0 ? slab_size : POOL_SLAB_SIZE;
     }
-    return node;
+    return pool;
 }
 
-void rmNode(Node *node)
+void rmPool(Pool *pool)
 {
-    if (node != NULL)
+    Slab *slab, *cur_slab;
+    if (pool != NULL)
     {
-        free(node);
+        slab = pool->head_slab;
+        while (slab != NULL)
+        {
+            cur_slab = slab;
+            slab = cur_slab->next_slab;
+            free(cur_slab);
+        }
+        free(pool);
     }
 }
 
-void node_SetData(Node *node, void *data)
+void *pool_Alloc(Pool *pool, size_t size)
 {
-    node->data = data;
+    Slab *slab = pool->head_slab;
+    size_t header = (sizeof(Slab) + POOL_ALIGN - 1) & ~(size_t) (POOL_ALIGN - 1);
+    size_t slab_size;
+    void *data;
+    size = (size + POOL_ALIGN - 1) & ~(size_t) (POOL_ALIGN - 1);
+    if (slab == NULL || slab->size - slab->used < size)
+    {
+        slab_size = pool->slab_size;
+        if (slab_size < header + size)
+            slab_size = header + size;
+        slab = (Slab *) malloc(slab_size);
+        if (slab == NULL)
+            return NULL;
+        slab->used = header;
+        slab->size = slab_size;
+        slab->next_slab = pool->head_slab;
+        pool->head_slab = slab;
+    }
+    data = (char *) slab + slab->used;
+    slab->used += size;
+    return data;
 }
 
-void *node_GetData(Node *node)
+/* Allocates a Chunk from the List's pool when it has one */
+static Chunk *list_MkChunk(List *list)
 {
-    return node->data;
+    Chunk *chunk;
+    if (list->pool == NULL)
+        chunk = (Chunk *) malloc(sizeof(Chunk));
+    else
+        chunk = (Chunk *) pool_Alloc(list->pool, sizeof(Chunk));
+    perf_CountAlloc(PERF_CHUNK, sizeof(Chunk));
+    if (chunk != NULL)
+    {
+        chunk->next_chunk = NULL;
+        chunk->prev_chunk = NULL;
+        chunk->count = 0;
+    }
+    return chunk;
 }
 
-void node_SetNext(Node *node, Node *next_node)
+/* Unlinks a Chunk from the List & frees it unless it lives in the pool */
+static void list_RmChunk(List *list, Chunk *chunk)
 {
-    node->next_node = next_node;
+    if (chunk->prev_chunk != NULL)
+        chunk->prev_chunk->next_chunk = chunk->next_chunk;
+    else
+        list->head_chunk = chunk->next_chunk;
+    if (chunk->next_chunk != NULL)
+        chunk->next_chunk->prev_chunk = chunk->prev_chunk;
+    else
+        list->tail_chunk = chunk->prev_chunk;
+    if (list->cursor_chunk == chunk)
+    {
+        list->cursor_chunk = NULL;
+        list->cursor_index = 0;
+    }
+    if (list->pool == NULL)
+        free(chunk);
 }
 
-Node *node_GetNext(Node *node)
+/* Finds the Chunk holding an index & makes it the cursor
+ *
+ * The walk starts from the tail, the cursor or the head, whichever is
+ * nearest. index must be in range.
+ * */
+static Chunk *list_Seek(List *list, int index, int *offset)
 {
-    return node->next_node;
+    Chunk *chunk = list->head_chunk;
+    int start = 0;
+    if (index >= list->size - list->tail_chunk->count)
+    {
+        chunk = list->tail_chunk;
+        start = list->size - chunk->count;
+    }
+    else if (list->cursor_chunk != NULL)
+    {
+        if (index >= list->cursor_index)
+        {
+            chunk = list->cursor_chunk;
+            start = list->cursor_index;
+        }
+        else if (list->cursor_index - index < index)
+        {
+            chunk = list->cursor_chunk;
+            start = list->cursor_index;
+            while (index < start)
+            {
+                chunk = chunk->prev_chunk;
+                start -= chunk->count;
+            }
+        }
+    }
+    while (index >= start + chunk->count)
+    {
+        start += chunk->count;
+        chunk = chunk->next_chunk;
+    }
+    list->cursor_chunk = chunk;
+    list->cursor_index = start;
+    *offset = index - start;
+    return chunk;
 }
 
 /*List specific functions*/
 List *mkList()
 {
     List *list = (List *) malloc(sizeof(List));
-    list->head_node = NULL;
-    list->tail_node = NULL;
-    list->size = 0;
+    if (list != NULL)
+    {
+        list->head_chunk = NULL;
+        list->tail_chunk = NULL;
+        list->size = 0;
+        list->pool = NULL;
+        list->cursor_chunk = NULL;
+        list->cursor_index = 0;
+    }
     return list;
 }
 
-void rmList(List *list)
+List *mkListPooled(size_t slab_size)
 {
-    Node *node = list->head_node, *cur_node;
-    if (list != NULL && list->size > 0)
+    List *list = mkList();
+    if (list != NULL)
     {
-        while (node != NULL)
+        list->pool = mkPool(slab_size);
+        if (list->pool == NULL)
         {
-            cur_node = node;
-            node = node_GetNext(cur_node);
-            if (cur_node != NULL)
-                free(cur_node);
-            
+            free(list);
+            return NULL;
         }
-        free(list);
     }
+    return list;
 }
 
-bool list_isEmpty(List *list)
+void *list_Alloc(List *list, size_t size)
 {
-    return list->head_node == NULL && list->tail_node == NULL;
+    if (list->pool == NULL)
+        return malloc(size);
+    return pool_Alloc(list->pool, size);
 }
 
-bool listNode_isHead(List *list, Node *node)
+void rmList(List *list)
 {
-    return list->head_node == node;
+    Chunk *chunk, *cur_chunk;
+    if (list == NULL)
+        return;
+    if (list->pool != NULL)
+    {
+        rmPool(list->pool);
+    }
+    else
+    {
+        chunk = list->head_chunk;
+        while (chunk != NULL)
+        {
+            cur_chunk = chunk;
+            chunk = cur_chunk->next_chunk;
+            free(cur_chunk);
+        }
+    }
+    free(list);
 }
 
-bool listNode_isTail(List *list, Node *node)
+bool list_isEmpty(List *list)
 {
-    return list->tail_node == node;
+    return list->size == 0;
 }
 
 int list_Count(List *list)
 {
-    Node *node = list->head_node;
-    int count = 0;
-    if (list != NULL)
-    {
-        while (node != NULL)
-        {
-            node = node_GetNext(node);
-            count++;
-        }
-    }
-    return count;
+    if (list == NULL)
+        return 0;
+    return list->size;
 }
 
 void list_Append(List *list, void *data)
 {
-    Node *node = mkNode(data, NULL);
-    if (list_isEmpty(list))
-    {
-        list->head_node = node;
-        list->tail_node = node;
-    }
-    else
+    Chunk *chunk = list->tail_chunk;
+    if (chunk == NULL || chunk->count == LIST_CHUNK_SIZE)
     {
-        list->tail_node->next_node = node;
-        list->tail_node = node;
+        chunk = list_MkChunk(list);
+        if (chunk == NULL)
+            return;
+        chunk->prev_chunk = list->tail_chunk;
+        if (list->tail_chunk == NULL)
+            list->head_chunk = chunk;
+        else
+            list->tail_chunk->next_chunk = chunk;
+        list->tail_chunk = chunk;
     }
+    chunk->data[chunk->count++] = data;
     list->size++;
 }
 
 void list_Prepend(List *list, void *data)
 {
-    Node *node = mkNode(data, list->head_node);
-    if (list_isEmpty(list))
-    {
-        list->tail_node = node;
-    }
-    list->head_node = node;
-    list->size++;
+    list_AddAt(list, data, 0);
 }
 
 void list_AddAt(List *list, void *data, int index)
 {
-    Node *node, *prevNode, *nextNode;
-    int loopVar;
-    if (list_isEmpty(list))
+    Chunk *chunk, *nextChunk;
+    int offset, half;
+    if (list_isEmpty(list) || index == list->size)
     {
-        node = mkNode(data, NULL);
-        list->head_node = node;
-        list->tail_node = node;
+        list_Append(list, data);
+        return;
     }
-    else
+    if (index < 0 || index > list->size)
+        return;
+    chunk = list_Seek(list, index, &offset);
+    if (chunk->count == LIST_CHUNK_SIZE)
     {
-        if (index == 0)
-        {
-            list_Prepend(list, data);
-        }
-        else if (index == list_Count(list))
-        {
-            list_Append(list, data);
-        }
-        else if (index < list->size)
+        /* Split a full Chunk, the upper half moves to a new Chunk */
+        nextChunk = list_MkChunk(list);
+        if (nextChunk == NULL)
+            return;
+        half = LIST_CHUNK_SIZE / 2;
+        memcpy(nextChunk->data, chunk->data + half, (LIST_CHUNK_SIZE - half) * sizeof(void *));
+        nextChunk->count = LIST_CHUNK_SIZE - half;
+        chunk->count = half;
+        nextChunk->prev_chunk = chunk;
+        nextChunk->next_chunk = chunk->next_chunk;
+        if (chunk->next_chunk != NULL)
+            chunk->next_chunk->prev_chunk = nextChunk;
+        else
+            list->tail_chunk = nextChunk;
+        chunk->next_chunk = nextChunk;
+        if (offset > half)
         {
-            nextNode = list->head_node;
-            for (loopVar = 0; loopVar < index; loopVar++)
-            {
-                prevNode = nextNode;
-                nextNode = node_GetNext(prevNode);
-            }
-            node =  mkNode(data, nextNode);
-            prevNode->next_node = node;
-            if (nextNode == NULL)
-            {
-                list->tail_node = node;
-            }
-            list->size++;
+            offset -= half;
+            chunk = nextChunk;
+            list->cursor_chunk = chunk;
+            list->cursor_index += half;
         }
     }
+    memmove(chunk->data + offset + 1, chunk->data + offset, (chunk->count - offset) * sizeof(void *));
+    chunk->data[offset] = data;
+    chunk->count++;
+    list->size++;
 }
 
 void *list_GetAt(List *list, int index)
 {
-    int loopVar = 0;
-    Node *node = list->head_node;
-    if (index <= list->size)
-    {
-        if (list != NULL)
-        {
-            if (index == 0)
-            {
-                return list->head_node->data;
-            }
-            else if (index == list->size - 1)
-            {
-                return list->tail_node->data;
-            }
-            for (loopVar = 0; loopVar < index; loopVar++)
-            {
-                node = node_GetNext(node);
-            }
-            return node->data;
-        }
-        else
-        {
-            return NULL;
-        }
-    }
-    else
-    {
+    Chunk *chunk;
+    int offset;
+    if (list == NULL || index < 0 || index >= list->size)
         return NULL;
-    }
+    chunk = list->cursor_chunk;
+    /* Cached cursor, sequential reads stay inside one Chunk */
+    if (chunk != NULL && index >= list->cursor_index && index < list->cursor_index + chunk->count)
+        return chunk->data[index - list->cursor_index];
+    chunk = list_Seek(list, index, &offset);
+    return chunk->data[offset];
 }
 
 void list_PopAt(List *list, int index)
 {
-    Node *popNode, *prevNode, *nextNode;
-    int loopVar;
-    if (!list_isEmpty(list))
+    Chunk *chunk, *nextChunk;
+    int offset;
+    if (index < 0 || index >= list->size)
+        return;
+    chunk = list_Seek(list, index, &offset);
+    memmove(chunk->data + offset, chunk->data + offset + 1, (chunk->count - offset - 1) * sizeof(void *));
+    chunk->count--;
+    list->size--;
+    nextChunk = chunk->next_chunk;
+    if (chunk->count == 0)
     {
-        if (index == 0)
-        {
-            popNode = list->head_node;
-            list->head_node = node_GetNext(list->head_node);
-        }
-        else
-        {
-            nextNode = list->head_node;
-            for (loopVar = 0; loopVar < index; loopVar++)
-            {
-                prevNode = nextNode;
-                nextNode = node_GetNext(prevNode);
-            }
-            popNode = prevNode->next_node;
-            prevNode->next_node = node_GetNext(nextNode);
-            if (prevNode->next_node == NULL)
-            {
-                list->tail_node = prevNode;
-            }
-        }
-        rmNode(popNode);
-        list->size--;
+        list_RmChunk(list, chunk);
+    }
+    else if (nextChunk != NULL && chunk->count + nextChunk->count <= LIST_CHUNK_SIZE * 3 / 4)
+    {
+        /* Merge sparse neighbours so lookups keep skipping full Chunks */
+        memcpy(chunk->data + chunk->count, nextChunk->data, nextChunk->count * sizeof(void *));
+        chunk->count += nextChunk->count;
+        list_RmChunk(list, nextChunk);
     }
 }
-
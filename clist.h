@@ -19,123 +19,134 @@
     #define CLIST_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
-typedef struct Node
+typedef struct Slab
 {
-    void *data;
-    struct Node *next_node;
-}Node;
+    struct Slab *next_slab;
+    size_t used;
+    size_t size;
+}Slab;
 
 typedef struct
 {
-    Node *head_node;
-    Node *tail_node;
+    Slab *head_slab;
+    size_t slab_size;
+}Pool;
+
+/* Items held by one Chunk, sized so a Chunk fills 512 bytes */
+#define LIST_CHUNK_SIZE 62
+
+/* A List block holding up to LIST_CHUNK_SIZE data pointers in order */
+typedef struct Chunk
+{
+    struct Chunk *next_chunk;
+    struct Chunk *prev_chunk;
+    int count;
+    void *data[LIST_CHUNK_SIZE];
+}Chunk;
+
+/* An unrolled linked list, items are kept in Chunks so index lookups
+ * skip a whole Chunk per step. The Chunk of the last lookup is cached, so
+ * walking the List by increasing index is O(1) per item. */
+typedef struct
+{
+    Chunk *head_chunk;
+    Chunk *tail_chunk;
     int size;
+    Pool *pool;
+    /* Chunk of the last lookup & the index of its first item */
+    Chunk *cursor_chunk;
+    int cursor_index;
 }List;
 
-/* Allocates memory for Node
+/* Allocates memory for a Pool that hands out memory from large slabs
  *
  * Parameters:
- * *data:       Node data
- * *next_node:  Pointer to next node or NULL 
+ * slab_size:   Bytes per slab, 0 for the default size
  *
  * Returns:
- * Memory allocated to new Node
+ * Memory allocated to new Pool
  * */
-Node *mkNode(void *data, Node *next_node);
+Pool *mkPool(size_t slab_size);
 
-/* Removes memory allocated to Node
+/* Removes memory allocated to a Pool and every allocation made from it
  *
  * Parameters:
- * *node:       Node to free
+ * *pool:   Target Pool
  * */
-void rmNode(Node *node);
+void rmPool(Pool *pool);
 
-/* Sets node data
+/* Allocates memory from a Pool, it is only released by rmPool
  *
  * Parameters:
- * *node:   Target Node
- * *data:   Data to set to node
- * */
-void node_SetData(Node *node, void *data);
-
-/* Gets node data
+ * *pool:   Target Pool
+ * size:    Bytes to allocate
  *
- * Parameters:
- * *node:   Target Node
+ * Returns:
+ * Memory allocated or NULL
  * */
-void *node_GetData(Node *node);
+void *pool_Alloc(Pool *pool, size_t size);
 
-/* Sets a Node's pointed Node
- *
- * Parameters:
- * *node:       Target Node
- * *next_node:  Pointed Node
+/* Allocates memory for a List
  * */
-void node_SetNext(Node *node, Node *next_node);
-
+List *mkList();
 
-/* Gets a Node's pointed Node
+/* Allocates memory for a List whose Chunks are carved out of slabs
  *
  * Parameters:
- * *node:   Target Node
- * */
-Node *node_GetNext(Node *node);
-
-/* Allocates memory for a List
+ * slab_size:   Bytes per slab, 0 for the default size
+ *
+ * Returns:
+ * Memory allocated to new List
  * */
-List *mkList();
+List *mkListPooled(size_t slab_size);
 
 /* Removes memory allocated to List
+ *
+ * A pooled List releases its slabs in one pass, including any data
+ * allocated with list_Alloc.
  *
  * Parameters:
  * *list:   Target List
  * */
 void rmList(List *list);
 
-/* Checks if List is empty
+/* Allocates memory for List data, from the slabs of a pooled List
  *
- * Parameters:
- * *list:   Target List
- *
- * Returns:
- * true or false
- * */
-bool list_isEmpty(List *list);
-
-/* Checks if a Node is the head Node in a List
+ * Data from a pooled List is freed by rmList and must not be freed by
+ * the caller.
  *
  * Parameters:
  * *list:   Target List
- * *node:   Target Node
+ * size:    Bytes to allocate
  *
  * Returns:
- * true or false
+ * Memory allocated or NULL
  * */
-bool listNode_isHead(List *list, Node *node);
+void *list_Alloc(List *list, size_t size);
 
-/* Checks if a Node is the tail Node in a List
+/* Checks if List is empty
  *
  * Parameters:
  * *list:   Target List
- * *node:   Target Node
  *
  * Returns:
  * true or false
  * */
-bool listNode_isTail(List *list, Node *node);
+bool list_isEmpty(List *list);
 
-/* Gets number of items in a List
+/* Gets number of items in a List, O(1)
  *
  * Parameters:
  * *list:   Target List
  *
  * Returns:
- * Node count
+ * Item count
  * */
 int list_Count(List *list);
 
-/* Appends a Node to the List
+/* Appends an item to the List
  *
  * Parameters:
  * *list:   Target List
@@ -143,7 +154,7 @@ int list_Count(List *list);
  * */
 void list_Append(List *list, void *data);
 
-/* Prepends a Node to the List
+/* Prepends an item to the List
  *
  * Parameters:
  * *list:   Target List
@@ -151,28 +162,34 @@ void list_Append(List *list, void *data);
  * */
 void list_Prepend(List *list, void *data);
 
-/* Adds a Node at a certain index to the List
+/* Adds an item at a certain index to the List
  *
  * Parameters:
  * *list:   Target List
  * *data:   Target data
- * index:   Index to add Node
+ * index:   Index to add the item
  * */
 void list_AddAt(List *list, void *data, int index);
 
 /* Gets data at a certain index in the List
+ *
+ * Reading the same or the next index as the last lookup does not walk
+ * the List, so a loop over every index is O(n) in total.
  *
  * Parameters:
  * *list:   Target List
- * index:   Index to get Node data
+ * index:   Index to get the data of
+ *
+ * Returns:
+ * Data at index or NULL if index is out of range
  * */
 void *list_GetAt(List *list, int index);
 
-/* Deletes a node at a certain index in the List
+/* Deletes the item at a certain index in the List
  *
  * Parameters:
  * *list:   Target list
- * index:   Index to delete target Node
+ * index:   Index of the item to delete
  * */
 void list_PopAt(List *list, int index);
 #endif
@@ -1,67 +1,813 @@
+#define _POSIX_C_SOURCE 200809L
+/* For madvise, posix_madvise may ignore POSIX_MADV_DONTNEED */
+#define _DEFAULT_SOURCE
 #include "point.h"
 #include "clist.h"
 #include "curve.h"
-#include "stdio.h"
-#include "math.h"
+#include "stats.h"
+#include "perf.h"
+#include "range.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <float.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
-void initCurve(Curve *curve)
+/* Smallest number of points allocated once a Curve starts growing */
+#define CURVE_MIN_CAPACITY 256
+/* Memory budget when none is set */
+#define CURVE_DEFAULT_BUDGET ((size_t) 256 << 20)
+/* Bytes per point of a window: mapped x & y, transformed copies of them
+ * & the next window being read ahead */
+#define WINDOW_POINT_BYTES (6 * sizeof(double))
+
+/* Memory budget set by setMemoryBudget, 0 if not set */
+static size_t memoryBudget = 0;
+/* Load precision set by setLoadPrecision */
+static bool isLoadPrecisionSet = false;
+static CurvePrecision loadPrecision = PRECISION_DOUBLE;
+static double loadPrecisionStep = 0;
+
+/* @brief Compares two statistics, allowing for rounding
+ * @return Returns true if a & b agree to about 9 significant digits
+ * */
+static bool isClose(double a, double b)
+{
+    double scale = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return fabs(a - b) <= 1e-9 * scale + 1e-12;
+}
+
+/* @brief Folds one point into the statistics of a Curve
+ *
+ * Measures the new segment like calcCurveStats does, so kept statistics
+ * agree with a rescan up to rounding.
+ * @param *curve Target Curve
+ * @param index Index of the point, the point before it is already folded
+ * */
+static void curve_AddStats(Curve *curve, size_t index)
+{
+    Point loopPoint;
+    Point loopPointNext = curve_GetAt(curve, index);
+    if (index == 0)
+    {
+        curve->lowPoint = loopPointNext;
+        curve->highPoint = loopPointNext;
+        return;
+    }
+    loopPoint = curve_GetAt(curve, index - 1);
+    curve->length += calcPointLength(&loopPoint, &loopPointNext);
+    curve->area += calcPointArea(&loopPoint, &loopPointNext);
+    if (loopPointNext.y < curve->lowPoint.y)
+        curve->lowPoint = loopPointNext;
+    if (loopPointNext.y > curve->highPoint.y)
+        curve->highPoint = loopPointNext;
+}
+
+Curve *mkCurve()
+{
+    Curve *curve = (Curve *) malloc(sizeof(Curve));
+    if (curve != NULL)
+    {
+        curve->xs = NULL;
+        curve->ys = NULL;
+        curve->storage = PRECISION_DOUBLE;
+        curve->size = 0;
+        curve->capacity = 0;
+        curve->mapping = NULL;
+        curve->mappingSize = 0;
+        curve->isMappingClean = false;
+        curve->scaleX = 1;
+        curve->scaleY = 1;
+        curve->offsetX = 0;
+        curve->offsetY = 0;
+        curve->isAnalyzed = true;
+        curve->lowPoint.x = 0;
+        curve->lowPoint.y = 0;
+        curve->highPoint = curve->lowPoint;
+        curve->length = 0;
+        curve->area = 0;
+        curve->rangeIndex = NULL;
+        curve->precision = PRECISION_DOUBLE;
+        curve->precisionStep = 0;
+        curve->errorX = 0;
+        curve->errorY = 0;
+    }
+    return curve;
+}
+
+void rmCurve(Curve *curve)
+{
+    if (curve != NULL)
+    {
+        curve_Clear(curve);
+        free(curve);
+    }
+}
+
+void curve_Clear(Curve *curve)
+{
+    double startTime = perf_Start();
+    size_t size = curve->size;
+    if (curve->mapping != NULL)
+    {
+        munmap(curve->mapping, curve->mappingSize);
+    }
+    else
+    {
+        free(curve->xs);
+        free(curve->ys);
+    }
+    curve->xs = NULL;
+    curve->ys = NULL;
+    curve->storage = PRECISION_DOUBLE;
+    curve->size = 0;
+    curve->capacity = 0;
+    curve->mapping = NULL;
+    curve->mappingSize = 0;
+    curve->isMappingClean = false;
+    curve->scaleX = 1;
+    curve->scaleY = 1;
+    curve->offsetX = 0;
+    curve->offsetY = 0;
+    curve->isAnalyzed = true;
+    curve->lowPoint.x = 0;
+    curve->lowPoint.y = 0;
+    curve->highPoint = curve->lowPoint;
+    curve->length = 0;
+    curve->area = 0;
+    curve->precision = PRECISION_DOUBLE;
+    curve->precisionStep = 0;
+    curve->errorX = 0;
+    curve->errorY = 0;
+    rmRangeIndex(curve->rangeIndex);
+    curve->rangeIndex = NULL;
+    perf_Stop(PERF_CLEAR, startTime, 0, size);
+}
+
+bool curve_Reserve(Curve *curve, size_t capacity)
+{
+    size_t width = curve_CoordinateBytes(curve);
+    void *xs;
+    void *ys;
+    if (capacity <= curve->capacity)
+        return true;
+    if (curve->mapping != NULL)
+    {
+        /* Move the points off the mapping before they can grow */
+        xs = malloc(capacity * width);
+        ys = malloc(capacity * width);
+        if (xs == NULL || ys == NULL)
+        {
+            free(xs);
+            free(ys);
+            return false;
+        }
+        perf_CountAlloc(PERF_ARRAY, capacity * width);
+        perf_CountAlloc(PERF_ARRAY, capacity * width);
+        memcpy(xs, curve->xs, curve->size * width);
+        memcpy(ys, curve->ys, curve->size * width);
+        munmap(curve->mapping, curve->mappingSize);
+        curve->mapping = NULL;
+        curve->mappingSize = 0;
+        curve->isMappingClean = false;
+        curve->xs = xs;
+        curve->ys = ys;
+        curve->capacity = capacity;
+        return true;
+    }
+    xs = realloc(curve->xs, capacity * width);
+    if (xs == NULL)
+        return false;
+    perf_CountAlloc(PERF_ARRAY, capacity * width);
+    curve->xs = xs;
+    ys = realloc(curve->ys, capacity * width);
+    if (ys == NULL)
+        return false;
+    perf_CountAlloc(PERF_ARRAY, capacity * width);
+    curve->ys = ys;
+    curve->capacity = capacity;
+    return true;
+}
+
+bool curve_Shrink(Curve *curve)
+{
+    size_t width = curve_CoordinateBytes(curve);
+    void *xs;
+    void *ys;
+    /* Keep one slot so the arrays stay allocated */
+    size_t capacity = curve->size > 0 ? curve->size : 1;
+    if (curve->mapping != NULL)
+    {
+        xs = malloc(capacity * width);
+        ys = malloc(capacity * width);
+        if (xs == NULL || ys == NULL)
+        {
+            free(xs);
+            free(ys);
+            return false;
+        }
+        perf_CountAlloc(PERF_ARRAY, capacity * width);
+        perf_CountAlloc(PERF_ARRAY, capacity * width);
+        memcpy(xs, curve->xs, curve->size * width);
+        memcpy(ys, curve->ys, curve->size * width);
+        munmap(curve->mapping, curve->mappingSize);
+        curve->mapping = NULL;
+        curve->mappingSize = 0;
+        curve->isMappingClean = false;
+        curve->xs = xs;
+        curve->ys = ys;
+        curve->capacity = capacity;
+        return true;
+    }
+    if (capacity >= curve->capacity)
+        return true;
+    /* Shrinking gives memory back, it is not counted as an allocation */
+    xs = realloc(curve->xs, capacity * width);
+    if (xs == NULL)
+        return false;
+    curve->xs = xs;
+    ys = realloc(curve->ys, capacity * width);
+    /* xs already shrank, so capacity is the smaller array either way */
+    curve->capacity = capacity;
+    if (ys == NULL)
+        return false;
+    curve->ys = ys;
+    return true;
+}
+
+size_t curve_CoordinateBytes(const Curve *curve)
+{
+    return curve->storage == PRECISION_DOUBLE ? sizeof(double) : sizeof(float);
+}
+
+size_t curve_Bytes(Curve *curve)
+{
+    return curve->capacity * 2 * curve_CoordinateBytes(curve);
+}
+
+bool curve_Append(Curve *curve, double x, double y)
+{
+    size_t capacity;
+    if ((!curve_IsCommitted(curve) || curve->storage != PRECISION_DOUBLE) && !curve_Commit(curve))
+        return false;
+    if (curve->size == curve->capacity)
+    {
+        /* Double the arrays so appends stay amortized O(1) */
+        capacity = curve->capacity * 2;
+        if (capacity < CURVE_MIN_CAPACITY)
+            capacity = CURVE_MIN_CAPACITY;
+        if (!curve_Reserve(curve, capacity))
+            return false;
+    }
+    ((double *) curve->xs)[curve->size] = x;
+    ((double *) curve->ys)[curve->size] = y;
+    curve->size++;
+    if (curve->rangeIndex != NULL && !rangeIndex_Append(curve->rangeIndex, curve))
+    {
+        rmRangeIndex(curve->rangeIndex);
+        curve->rangeIndex = NULL;
+    }
+    /* Statistics that are current stay current in O(1) */
+    if (curve->isAnalyzed)
+        curve_AddStats(curve, curve->size - 1);
+    return true;
+}
+
+void curve_Map(Curve *curve, void *mapping, size_t mappingSize, double *xs, double *ys, size_t size)
+{
+    curve_Clear(curve);
+    curve->mapping = mapping;
+    curve->mappingSize = mappingSize;
+    curve->isMappingClean = true;
+    curve->xs = xs;
+    curve->ys = ys;
+    curve->size = size;
+    curve->capacity = size;
+    curve->isAnalyzed = false;
+}
+
+size_t curve_WindowPoints()
+{
+    size_t points = getMemoryBudget() / WINDOW_POINT_BYTES;
+    return points > 0 ? points : 1;
+}
+
+/* @brief Reads ahead or drops the pages of a run of doubles
+ *
+ * Only pages entirely inside the run are dropped, pages shared with the
+ * neighbouring windows stay.
+ * */
+static void adviseRange(double *begin, double *end, bool isNeeded)
+{
+    uintptr_t page = (uintptr_t) sysconf(_SC_PAGESIZE);
+    uintptr_t low = (uintptr_t) begin;
+    uintptr_t high = (uintptr_t) end;
+    if (isNeeded)
+    {
+        low &= ~(page - 1);
+        posix_madvise((void *) low, high - low, POSIX_MADV_WILLNEED);
+        return;
+    }
+    low = (low + page - 1) & ~(page - 1);
+    high &= ~(page - 1);
+    if (low < high)
+        madvise((void *) low, high - low, MADV_DONTNEED);
+}
+
+void curve_AdviseWindow(Curve *curve, size_t first, size_t end, bool isNeeded)
+{
+    if (curve->mapping == NULL || first >= end || (!isNeeded && !curve->isMappingClean))
+        return;
+    adviseRange((double *) curve->xs + first, (double *) curve->xs + end, isNeeded);
+    adviseRange((double *) curve->ys + first, (double *) curve->ys + end, isNeeded);
+}
+
+size_t getMemoryBudget()
+{
+    const char *setting;
+    if (memoryBudget > 0)
+        return memoryBudget;
+    setting = getenv("NCURVECALC_BUDGET");
+    if (setting != NULL && atol(setting) > 0)
+        return (size_t) atol(setting) << 20;
+    return CURVE_DEFAULT_BUDGET;
+}
+
+void setMemoryBudget(size_t bytes)
+{
+    memoryBudget = bytes;
+}
+
+CurvePrecision getLoadPrecision(double *step)
+{
+    CurvePrecision precision;
+    const char *setting;
+    if (isLoadPrecisionSet)
+    {
+        *step = loadPrecisionStep;
+        return loadPrecision;
+    }
+    setting = getenv("NCURVECALC_PRECISION");
+    if (setting != NULL && parsePrecision(setting, &precision, step))
+        return precision;
+    *step = 0;
+    return PRECISION_DOUBLE;
+}
+
+void setLoadPrecision(CurvePrecision precision, double step)
+{
+    isLoadPrecisionSet = true;
+    loadPrecision = precision;
+    loadPrecisionStep = precision == PRECISION_FIXED ? step : 0;
+}
+
+bool parsePrecision(const char *text, CurvePrecision *precision, double *step)
+{
+    char *end;
+    *step = 0;
+    if (strcmp(text, "double") == 0)
+    {
+        *precision = PRECISION_DOUBLE;
+        return true;
+    }
+    if (strcmp(text, "float") == 0)
+    {
+        *precision = PRECISION_FLOAT;
+        return true;
+    }
+    *step = strtod(text, &end);
+    if (end == text || *end != '\0' || !(*step > 0) || *step > DBL_MAX)
+        return false;
+    *precision = PRECISION_FIXED;
+    return true;
+}
+
+const char *precisionName(CurvePrecision precision)
+{
+    switch (precision)
+    {
+        case PRECISION_FLOAT:
+            return "float";
+        case PRECISION_FIXED:
+            return "fixed";
+        default:
+            break;
+    }
+    return "double";
+}
+
+/* @brief Rounds an array of doubles to floats or to 32 bit multiples of
+ * a step, in place
+ *
+ * Each value lands at or before the double it is read from, so a forward
+ * pass never overwrites a double still to be read. Values go through
+ * memcpy so the compiler cannot reorder the two views of the bytes.
+ * */
+static void narrowInPlace(void *values, size_t count, CurvePrecision precision, double step)
+{
+    unsigned char *bytes = (unsigned char *) values;
+    double value;
+    float single;
+    int32_t code;
+    size_t index;
+    for (index = 0; index < count; index++)
+    {
+        memcpy(&value, bytes + index * sizeof(double), sizeof(double));
+        if (precision == PRECISION_FLOAT)
+        {
+            single = (float) value;
+            memcpy(bytes + index * sizeof(float), &single, sizeof(float));
+        }
+        else
+        {
+            code = (int32_t) round(value / step);
+            memcpy(bytes + index * sizeof(int32_t), &code, sizeof(int32_t));
+        }
+    }
+}
+
+bool curve_Quantize(Curve *curve, CurvePrecision precision, double step)
+{
+    double largestX = 0, largestY = 0, limit;
+    double *xs, *ys;
+    void *shrunk;
+    size_t index;
+    if (precision == PRECISION_DOUBLE || curve->mapping != NULL)
+        return true;
+    if (precision == PRECISION_FIXED && !(step > 0))
+        return false;
+    if ((!curve_IsCommitted(curve) || curve->storage != PRECISION_DOUBLE) && !curve_Commit(curve))
+        return false;
+    xs = (double *) curve->xs;
+    ys = (double *) curve->ys;
+    for (index = 0; index < curve->size; index++)
+    {
+        /* Written so NaN fails the range checks below */
+        if (!(fabs(xs[index]) <= largestX))
+            largestX = fabs(xs[index]);
+        if (!(fabs(ys[index]) <= largestY))
+            largestY = fabs(ys[index]);
+    }
+    if (precision == PRECISION_FLOAT)
+        limit = FLT_MAX;
+    else
+        limit = (INT32_MAX - 0.5) * step;
+    if (!(largestX <= limit) || !(largestY <= limit))
+        return false;
+    narrowInPlace(curve->xs, curve->size, precision, step);
+    narrowInPlace(curve->ys, curve->size, precision, step);
+    /* Give back the half of each array the narrow values do not use */
+    shrunk = realloc(curve->xs, (curve->size > 0 ? curve->size : 1) * sizeof(float));
+    if (shrunk != NULL)
+        curve->xs = shrunk;
+    shrunk = realloc(curve->ys, (curve->size > 0 ? curve->size : 1) * sizeof(float));
+    if (shrunk != NULL)
+        curve->ys = shrunk;
+    curve->capacity = curve->size;
+    curve->storage = precision;
+    if (precision == PRECISION_FLOAT)
+    {
+        /* Half an ulp of the largest value, or of the smallest float */
+        curve->errorX = largestX * (FLT_EPSILON / 2) + FLT_MIN * (FLT_EPSILON / 2);
+        curve->errorY = largestY * (FLT_EPSILON / 2) + FLT_MIN * (FLT_EPSILON / 2);
+    }
+    else
+    {
+        /* Half a step, plus the rounding of n * step */
+        curve->errorX = step / 2 + (largestX + step) * DBL_EPSILON;
+        curve->errorY = step / 2 + (largestY + step) * DBL_EPSILON;
+    }
+    curve->precision = precision;
+    curve->precisionStep = precision == PRECISION_FIXED ? step : 0;
+    curve_Invalidate(curve);
+    return true;
+}
+
+void curve_ErrorBounds(Curve *curve, double *length, double *area)
+{
+    double segments = curve->size > 1 ? (double) (curve->size - 1) : 0;
+    double largestY, spanX = 0;
+    if (!curve->isAnalyzed)
+        initCurve(curve);
+    largestY = fabs(curve->lowPoint.y) > fabs(curve->highPoint.y) ? fabs(curve->lowPoint.y) : fabs(curve->highPoint.y);
+    if (curve->size > 1)
+        spanX = fabs(curve_GetAt(curve, curve->size - 1).x - curve_GetAt(curve, 0).x);
+    /* Both ends of a segment move by at most errorX & errorY */
+    *length = segments * 2 * hypot(curve->errorX, curve->errorY);
+    /* |dx| grows by at most 2 errorX & the mean |y| by at most errorY */
+    *area = segments * 2 * curve->errorX * (largestY + curve->errorY) + spanX * curve->errorY;
+}
+
+Point curve_GetAt(Curve *curve, size_t index)
+{
+    Point point;
+    point.x = curve_StoredX(curve, index) * curve->scaleX + curve->offsetX;
+    point.y = curve_StoredY(curve, index) * curve->scaleY + curve->offsetY;
+    return point;
+}
+
+List *curve_ToList(Curve *curve)
+{
+    size_t index;
+    List *list = mkListPooled(0);
+    Point point;
+    for (index = 0; index < curve->size; index++)
+    {
+        point = curve_GetAt(curve, index);
+        list_Append(list, mkPointPooled(list->pool, point.x, point.y));
+    }
+    return list;
+}
+
+bool curve_FromList(Curve *curve, List *list)
 {
-    double length = 0, area = 0;
-    Node *node;
-    Node *node_now;
     Point *loopPoint;
-    Point *loopPointNext;
-    Point *lowPoint;
-    Point *highPoint;
-    node = curve->list->head_node;
-    if (curve->list != NULL && curve->list->size > 0)
-    {
-        lowPoint = curve->list->head_node->data;
-        highPoint = curve->list->head_node->data;
-        while (node != NULL)
+    int index;
+    curve_Clear(curve);
+    if (!curve_Reserve(curve, list->size))
+        return false;
+    for (index = 0; index < list->size; index++)
+    {
+        loopPoint = list_GetAt(list, index);
+        ((double *) curve->xs)[curve->size] = loopPoint->x;
+        ((double *) curve->ys)[curve->size] = loopPoint->y;
+        curve->size++;
+    }
+    curve->isAnalyzed = false;
+    return true;
+}
+
+void initCurve(Curve *curve)
+{
+    curve_Analyze(curve, 0);
+}
+
+/* @brief Calculates the statistics of a memory mapped Curve one window at
+ * a time
+ *
+ * A pending transform is applied to a copy of each window instead of the
+ * mapping, so no page of the file is written.
+ * @return Returns false if memory for the copies could not be allocated
+ * */
+static bool analyzeWindows(Curve *curve, int threads, CurveStats *stats)
+{
+    CurveStats window;
+    size_t windowPoints = curve_WindowPoints();
+    size_t start, first, end, ahead, index;
+    double *xs = NULL;
+    double *ys = NULL;
+    const double *windowXs, *windowYs;
+    double lowY = 0, highY = 0;
+    bool isTransformed = !curve_IsCommitted(curve);
+    if (isTransformed)
+    {
+        xs = (double *) malloc((windowPoints + 1) * sizeof(double));
+        ys = (double *) malloc((windowPoints + 1) * sizeof(double));
+        if (xs == NULL || ys == NULL)
         {
-            node_now = node;
-            node = node_GetNext(node);
-            loopPoint = node_now->data;
-            if (node != NULL)
+            free(xs);
+            free(ys);
+            return false;
+        }
+    }
+    stats->length = 0;
+    stats->area = 0;
+    stats->lowIndex = 0;
+    stats->highIndex = 0;
+    curve_AdviseWindow(curve, 0, windowPoints < curve->size ? windowPoints : curve->size, true);
+    for (start = 0; start < curve->size; start = end)
+    {
+        end = curve->size - start > windowPoints ? start + windowPoints : curve->size;
+        ahead = curve->size - end > windowPoints ? end + windowPoints : curve->size;
+        curve_AdviseWindow(curve, end, ahead, true);
+        /* Windows after the first start at the last point of the one
+         * before, for the segment joining them */
+        first = start > 0 ? start - 1 : 0;
+        if (isTransformed)
+        {
+            for (index = first; index < end; index++)
             {
-                loopPointNext = node->data;
-                length += calcPointLength(loopPoint, loopPointNext);
-                area += calcPointArea(loopPoint, loopPointNext);
-                if (loopPointNext->y < lowPoint->y)
-                    lowPoint = loopPointNext;
-                if (loopPointNext->y > highPoint->y)
-                    highPoint = loopPointNext;
+                xs[index - first] = ((double *) curve->xs)[index] * curve->scaleX + curve->offsetX;
+                ys[index - first] = ((double *) curve->ys)[index] * curve->scaleY + curve->offsetY;
             }
+            windowXs = xs;
+            windowYs = ys;
+        }
+        else
+        {
+            windowXs = (double *) curve->xs + first;
+            windowYs = (double *) curve->ys + first;
+        }
+        calcCurveStatsParallel(windowXs, windowYs, end - first, threads, &window);
+        stats->length += window.length;
+        stats->area += window.area;
+        /* Strictly lower & higher keep the first extreme, as in one pass */
+        if (start == 0 || windowYs[window.lowIndex] < lowY)
+        {
+            lowY = windowYs[window.lowIndex];
+            stats->lowIndex = first + window.lowIndex;
+        }
+        if (start == 0 || windowYs[window.highIndex] > highY)
+        {
+            highY = windowYs[window.highIndex];
+            stats->highIndex = first + window.highIndex;
         }
+        curve_AdviseWindow(curve, first, end, false);
+    }
+    free(xs);
+    free(ys);
+    return true;
+}
+
+void curve_Analyze(Curve *curve, int threads)
+{
+    CurveStats stats;
+    NarrowCoordinates narrow;
+    double startTime = perf_Start();
+    if (curve->storage != PRECISION_DOUBLE)
+    {
+        /* Widened & transformed as they are read, nothing is committed */
+        narrow.xs = curve->xs;
+        narrow.ys = curve->ys;
+        narrow.isFixed = curve->storage == PRECISION_FIXED;
+        narrow.step = curve->precisionStep;
+        narrow.scaleX = curve->scaleX;
+        narrow.scaleY = curve->scaleY;
+        narrow.offsetX = curve->offsetX;
+        narrow.offsetY = curve->offsetY;
+        calcCurveStatsNarrowParallel(&narrow, curve->size, threads, &stats);
+    }
+    else if (curve->mapping == NULL || curve->size <= curve_WindowPoints() || !analyzeWindows(curve, threads, &stats))
+    {
+        if (!curve_IsCommitted(curve))
+            curve_Commit(curve);
+        calcCurveStatsParallel(curve->xs, curve->ys, curve->size, threads, &stats);
+    }
+    curve->length = stats.length;
+    curve->area = stats.area;
+    curve->lowPoint.x = 0;
+    curve->lowPoint.y = 0;
+    curve->highPoint = curve->lowPoint;
+    if (curve->size > 0)
+    {
+        curve->lowPoint = curve_GetAt(curve, stats.lowIndex);
+        curve->highPoint = curve_GetAt(curve, stats.highIndex);
     }
-    curve->length = length;
-    curve->area = area;
-    curve->lowPoint = lowPoint;
-    curve->highPoint = highPoint;
+    curve->isAnalyzed = true;
+    perf_Stop(PERF_INIT_CURVE, startTime, 0, curve->size);
+}
+
+bool curve_Verify(Curve *curve)
+{
+    double length = curve->length;
+    double area = curve->area;
+    Point lowPoint = curve->lowPoint;
+    Point highPoint = curve->highPoint;
+    bool wasAnalyzed = curve->isAnalyzed;
+    initCurve(curve);
+    return wasAnalyzed && isClose(length, curve->length) && isClose(area, curve->area)
+        && isClose(lowPoint.x, curve->lowPoint.x) && isClose(lowPoint.y, curve->lowPoint.y)
+        && isClose(highPoint.x, curve->highPoint.x) && isClose(highPoint.y, curve->highPoint.y);
 }
 
 void mvCurve(Curve *curve, double shiftX, double shiftY)
 {
-    Node *node;
-    Node *node_now;
-    Point *loopPoint;
-    Point *loopPointNext;
-    node = curve->list->head_node;
-    if (curve->list != NULL && curve->list->size > 0)
+    curve_Transform(curve, 1, 1, shiftX, shiftY);
+}
+
+/* @brief Records a transform & updates the statistics, see curve_Transform
+ * */
+static void curve_Record(Curve *curve, double scaleX, double scaleY, double shiftX, double shiftY)
+{
+    Point first, last, swap;
+    double span;
+    curve->scaleX *= scaleX;
+    curve->scaleY *= scaleY;
+    curve->offsetX = curve->offsetX * scaleX + shiftX;
+    curve->offsetY = curve->offsetY * scaleY + shiftY;
+    if (!curve->isAnalyzed || curve->size == 0)
+        return;
+    /* Scaling stretches the area by |scaleX * scaleY| and the length only
+     * when both axes scale alike */
+    curve->area *= fabs(scaleX * scaleY);
+    if (fabs(scaleX) == fabs(scaleY))
+        curve->length *= fabs(scaleX);
+    else
+        curve->isAnalyzed = false;
+    if (scaleY < 0)
     {
-        loopPoint = node->data;
-        shiftPoint(loopPoint, shiftX, shiftY);
-        while (node != NULL)
+        swap = curve->lowPoint;
+        curve->lowPoint = curve->highPoint;
+        curve->highPoint = swap;
+    }
+    curve->lowPoint.x = curve->lowPoint.x * scaleX + shiftX;
+    curve->lowPoint.y = curve->lowPoint.y * scaleY;
+    curve->highPoint.x = curve->highPoint.x * scaleX + shiftX;
+    curve->highPoint.y = curve->highPoint.y * scaleY;
+    /* X is monotonic, so the segment widths add up to the x span and a
+     * shift that keeps every y on one side of 0 moves the area by
+     * shiftY * span */
+    first = curve_GetAt(curve, 0);
+    last = curve_GetAt(curve, curve->size - 1);
+    span = fabs(last.x - first.x);
+    if (curve->lowPoint.y >= 0 && curve->lowPoint.y + shiftY >= 0)
+        curve->area += shiftY * span;
+    else if (curve->highPoint.y <= 0 && curve->highPoint.y + shiftY <= 0)
+        curve->area -= shiftY * span;
+    else if (shiftY != 0)
+        curve->isAnalyzed = false;
+    curve->lowPoint.y += shiftY;
+    curve->highPoint.y += shiftY;
+}
+
+void curve_Transform(Curve *curve, double scaleX, double scaleY, double shiftX, double shiftY)
+{
+    double startTime = perf_Start();
+    curve_Record(curve, scaleX, scaleY, shiftX, shiftY);
+    curve->errorX *= fabs(scaleX);
+    curve->errorY *= fabs(scaleY);
+    perf_Stop(PERF_TRANSFORM, startTime, 0, 0);
+}
+
+/* @brief Moves the points of a Curve at a lower precision back to double
+ * storage, applying the pending transform on the way
+ * @return Returns false if memory could not be allocated
+ * */
+static bool curve_Widen(Curve *curve)
+{
+    double *xs = (double *) malloc((curve->capacity > 0 ? curve->capacity : 1) * sizeof(double));
+    double *ys = (double *) malloc((curve->capacity > 0 ? curve->capacity : 1) * sizeof(double));
+    size_t index;
+    if (xs == NULL || ys == NULL)
+    {
+        free(xs);
+        free(ys);
+        return false;
+    }
+    perf_CountAlloc(PERF_ARRAY, curve->capacity * sizeof(double));
+    perf_CountAlloc(PERF_ARRAY, curve->capacity * sizeof(double));
+    for (index = 0; index < curve->size; index++)
+    {
+        xs[index] = curve_StoredX(curve, index) * curve->scaleX + curve->offsetX;
+        ys[index] = curve_StoredY(curve, index) * curve->scaleY + curve->offsetY;
+    }
+    free(curve->xs);
+    free(curve->ys);
+    curve->xs = xs;
+    curve->ys = ys;
+    curve->storage = PRECISION_DOUBLE;
+    return true;
+}
+
+bool curve_Commit(Curve *curve)
+{
+    double *xs = (double *) curve->xs;
+    double *ys = (double *) curve->ys;
+    size_t index;
+    double startTime = perf_Start();
+    if (curve->storage != PRECISION_DOUBLE)
+    {
+        if (!curve_Widen(curve))
+            return false;
+    }
+    else
+    {
+        curve->isMappingClean = false;
+        for (index = 0; index < curve->size; index++)
         {
-            node_now = node;
-            node = node_GetNext(node);
-            loopPoint = node_now->data;
-            if (node != NULL)
-            {
-                loopPointNext = node->data;
-                shiftPoint(loopPointNext, shiftX, shiftY);
-            }
+            xs[index] = xs[index] * curve->scaleX + curve->offsetX;
+            ys[index] = ys[index] * curve->scaleY + curve->offsetY;
         }
     }
+    curve->scaleX = 1;
+    curve->scaleY = 1;
+    curve->offsetX = 0;
+    curve->offsetY = 0;
+    rmRangeIndex(curve->rangeIndex);
+    curve->rangeIndex = NULL;
+    perf_Stop(PERF_COMMIT, startTime, 0, curve->size);
+    return true;
+}
+
+void curve_Invalidate(Curve *curve)
+{
+    curve->isMappingClean = false;
+    rmRangeIndex(curve->rangeIndex);
+    curve->rangeIndex = NULL;
+    curve->isAnalyzed = false;
+}
+
+void curve_Swap(Curve *curve, Curve *other)
+{
+    Curve swap = *curve;
+    *curve = *other;
+    *other = swap;
+}
+
+bool curve_IsCommitted(Curve *curve)
+{
+    return curve->scaleX == 1 && curve->scaleY == 1 && curve->offsetX == 0 && curve->offsetY == 0;
 }
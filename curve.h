@@ -1,25 +1,367 @@
+#include "point.h"
 #include "clist.h"
 #ifndef CURVE_H
     #define CURVE_H
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* @brief Precision the coordinates of a Curve are rounded to when loaded
+ * */
+typedef enum
+{
+    /* Coordinates are kept as read */
+    PRECISION_DOUBLE,
+    /* Coordinates are rounded to the nearest float */
+    PRECISION_FLOAT,
+    /* Coordinates are rounded to the nearest multiple of a step that
+     * fits a 32 bit integer */
+    PRECISION_FIXED
+}CurvePrecision;
+
 /* @brief Curve structure, contains all information about a curve
+ *
+ * Points are kept as two contiguous arrays of coordinates so walks over
+ * the curve stream through memory instead of chasing List nodes. The
+ * arrays hold doubles, or after curve_Quantize floats or 32 bit multiples
+ * of precisionStep, see storage & curve_StoredX.
+ *
+ * Shifts & scales are not applied to the arrays straight away. A point
+ * of the curve is (xs[i] * scaleX + offsetX, ys[i] * scaleY + offsetY),
+ * use curve_GetAt to read points or curve_Commit to apply the transform.
  * */
 typedef struct
 {
-    List *list;
-    Point *lowPoint;
-    Point *highPoint;
+    /* X coordinates, one per point, of the type given by storage */
+    void *xs;
+    /* Y coordinates, one per point, of the type given by storage */
+    void *ys;
+    /* Type of xs & ys, double for PRECISION_DOUBLE, float for
+     * PRECISION_FLOAT & int32_t multiples of precisionStep for
+     * PRECISION_FIXED */
+    CurvePrecision storage;
+    /* Number of points in the curve */
+    size_t size;
+    /* Number of points allocated in xs & ys */
+    size_t capacity;
+    /* Memory mapped file holding xs & ys or NULL if they are on the heap */
+    void *mapping;
+    /* Bytes of the memory mapped file */
+    size_t mappingSize;
+    /* True while no stored coordinate in the mapping has been written, so
+     * mapped pages can be dropped & read back from the file */
+    bool isMappingClean;
+    /* Pending transform of the stored coordinates */
+    double scaleX;
+    double scaleY;
+    double offsetX;
+    double offsetY;
+    /* True if length, area, lowPoint & highPoint describe the points */
+    bool isAnalyzed;
+    Point lowPoint;
+    Point highPoint;
     double length;
     double area;
+    /* Segment sums for range queries over the stored coordinates, built
+     * on first use, see curve_RangeStats */
+    struct RangeIndex *rangeIndex;
+    /* Precision set by curve_Quantize & its step for PRECISION_FIXED,
+     * kept when storage goes back to double */
+    CurvePrecision precision;
+    double precisionStep;
+    /* Largest difference quantizing made to any x & any y, scaled along
+     * with the points */
+    double errorX;
+    double errorY;
 }Curve;
 
-/* @brief Initializes curve memory
+/* @brief Allocates memory for an empty Curve
+ * @return Memory of new Curve
+ * */
+Curve *mkCurve();
+
+/* @brief Frees memory allocated to a Curve and its points
+ * @param *curve Target Curve
+ * */
+void rmCurve(Curve *curve);
+
+/* @brief Removes all points from a Curve and releases their memory
+ * @param *curve Target Curve
+ * */
+void curve_Clear(Curve *curve);
+
+/* @brief Makes sure a Curve can hold a number of points without growing
+ * @param *curve Target Curve
+ * @param capacity Number of points to make room for
+ * @return Returns false if memory could not be allocated
+ * */
+bool curve_Reserve(Curve *curve, size_t capacity);
+
+/* @brief Releases the memory a Curve holds beyond its points
+ *
+ * Heap arrays are shrunk to the number of points, the points of a memory
+ * mapped Curve are copied to the heap & the mapping is dropped.
+ * @param *curve Target Curve
+ * @return Returns false if memory could not be allocated, the points are
+ * then left as they were
+ * */
+bool curve_Shrink(Curve *curve);
+
+/* @brief Gets the bytes of one stored coordinate of a Curve
+ * @param *curve Target Curve
+ * @return 8 for double storage, 4 otherwise
+ * */
+size_t curve_CoordinateBytes(const Curve *curve);
+
+/* @brief Gets the memory held by the points of a Curve
+ * @param *curve Target Curve
+ * @return Bytes allocated to, or mapped for, the coordinates
+ * */
+size_t curve_Bytes(Curve *curve);
+
+/* @brief Appends a point to the end of a Curve
+ *
+ * Length, area, lowPoint & highPoint are updated in O(1) if they were
+ * up to date before the append. Points are appended exactly, so a Curve
+ * at a lower precision goes back to double storage first.
+ * @param *curve Target Curve
+ * @param x Value of x
+ * @param y Value of y
+ * @return Returns false if memory could not be allocated
+ * */
+bool curve_Append(Curve *curve, double x, double y);
+
+/* @brief Makes a Curve use points stored in a memory mapped file
+ *
+ * The Curve takes ownership of the mapping and unmaps it when cleared.
+ * Pages are only read when points are accessed, and the points are
+ * copied to the heap the first time the Curve has to grow.
+ * @param *curve Target Curve, cleared first
+ * @param *mapping Start of the mapping
+ * @param mappingSize Bytes of the mapping
+ * @param *xs X coordinates inside the mapping
+ * @param *ys Y coordinates inside the mapping
+ * @param size Number of points
+ * */
+void curve_Map(Curve *curve, void *mapping, size_t mappingSize, double *xs, double *ys, size_t size);
+
+/* @brief Gets the number of points processed at a time by passes over a
+ * memory mapped Curve
+ *
+ * Whole passes such as statistics & saves walk a mapped Curve one window
+ * at a time and drop each window from memory once it is done, so memory
+ * in use stays within getMemoryBudget however large the file is.
+ * @return Points per window, at least 1
+ * */
+size_t curve_WindowPoints();
+
+/* @brief Hints the use of a window of points of a memory mapped Curve
+ *
+ * Does nothing for Curves on the heap. Windows are only dropped while
+ * isMappingClean, written pages have no copy to read back.
+ * @param *curve Target Curve
+ * @param first Index of the first point of the window
+ * @param end Index after the last point of the window
+ * @param isNeeded True to start reading the window ahead, false to drop it
+ * */
+void curve_AdviseWindow(Curve *curve, size_t first, size_t end, bool isNeeded);
+
+/* @brief Gets the memory budget of passes over memory mapped Curves
+ *
+ * Set by setMemoryBudget, else the NCURVECALC_BUDGET environment
+ * variable in megabytes, else 256 MB.
+ * @return Budget in bytes
+ * */
+size_t getMemoryBudget();
+
+/* @brief Sets the memory budget of passes over memory mapped Curves
+ * @param bytes Budget in bytes, 0 to go back to the default
+ * */
+void setMemoryBudget(size_t bytes);
+
+/* @brief Gets the precision loads round the coordinates to
+ *
+ * Set by setLoadPrecision, else the NCURVECALC_PRECISION environment
+ * variable as read by parsePrecision, else PRECISION_DOUBLE.
+ * @param *step Filled with the step of PRECISION_FIXED
+ * @return Precision of new loads
+ * */
+CurvePrecision getLoadPrecision(double *step);
+
+/* @brief Sets the precision loads round the coordinates to
+ * @param precision Precision of new loads
+ * @param step Step of PRECISION_FIXED, ignored otherwise
+ * */
+void setLoadPrecision(CurvePrecision precision, double step);
+
+/* @brief Reads a precision from text
+ * @param *text "double", "float" or the positive step of a fixed precision
+ * @param *precision Filled with the precision
+ * @param *step Filled with the step of PRECISION_FIXED
+ * @return Returns false if the text is not a precision
+ * */
+bool parsePrecision(const char *text, CurvePrecision *precision, double *step);
+
+/* @brief Gets the name of a precision
+ * @param precision Target precision
+ * @return "double", "float" or "fixed"
+ * */
+const char *precisionName(CurvePrecision precision);
+
+/* @brief Rounds every coordinate of a Curve to a lower precision
+ *
+ * The coordinates move to arrays of floats or 32 bit integers, half the
+ * memory of doubles. Commits the pending transform first & records the
+ * largest error the rounding can make in errorX & errorY. Statistics are
+ * left for a rescan, whose kernels read the floats or integers & widen
+ * each value as they accumulate in double. Only curve_Append &
+ * curve_Commit widen the arrays back to double.
+ *
+ * A memory mapped Curve is left as it is, rounding it would write every
+ * page of the file.
+ * @param *curve Target Curve
+ * @param precision Precision to round to, PRECISION_DOUBLE does nothing
+ * @param step Step of PRECISION_FIXED, ignored otherwise
+ * @return Returns false, leaving the Curve untouched, if a coordinate
+ * does not fit the precision
+ * */
+bool curve_Quantize(Curve *curve, CurvePrecision precision, double step);
+
+/* @brief Bounds how far quantizing moved the statistics of a Curve
+ *
+ * Assumes sequential x values, as loads require.
+ * @param *curve Target Curve, analyzed first if needed
+ * @param *length Filled with the largest error of the length
+ * @param *area Filled with the largest error of the area
+ * */
+void curve_ErrorBounds(Curve *curve, double *length, double *area);
+
+/* @brief Gets the x of a point before the pending transform
+ * @param *curve Target Curve
+ * @param index Index of the point
+ * @return Stored x widened to double
+ * */
+static inline double curve_StoredX(const Curve *curve, size_t index)
+{
+    if (curve->storage == PRECISION_FLOAT)
+        return ((const float *) curve->xs)[index];
+    if (curve->storage == PRECISION_FIXED)
+        return ((const int32_t *) curve->xs)[index] * curve->precisionStep;
+    return ((const double *) curve->xs)[index];
+}
+
+/* @brief Gets the y of a point before the pending transform
+ * @param *curve Target Curve
+ * @param index Index of the point
+ * @return Stored y widened to double
+ * */
+static inline double curve_StoredY(const Curve *curve, size_t index)
+{
+    if (curve->storage == PRECISION_FLOAT)
+        return ((const float *) curve->ys)[index];
+    if (curve->storage == PRECISION_FIXED)
+        return ((const int32_t *) curve->ys)[index] * curve->precisionStep;
+    return ((const double *) curve->ys)[index];
+}
+
+/* @brief Gets a point of a Curve
+ * @param *curve Target Curve
+ * @param index Index of the point
+ * @return Copy of the point at index
+ * */
+Point curve_GetAt(Curve *curve, size_t index);
+
+/* @brief Builds a List of Points from a Curve
+ *
+ * Compatibility shim for code that still walks Lists. The List is pooled,
+ * so one rmList releases it together with its Points.
+ * @param *curve Target Curve
+ * @return New List of new Points
+ * */
+List *curve_ToList(Curve *curve);
+
+/* @brief Replaces the points of a Curve with the Points of a List
+ * @param *curve Target Curve
+ * @param *list List of Points, left untouched
+ * @return Returns false if memory could not be allocated
+ * */
+bool curve_FromList(Curve *curve, List *list);
+
+/* @brief Recalculates length, area, lowPoint & highPoint from every point
+ *
+ * Only needed when the statistics are not kept up to date, see
+ * isAnalyzed.
  * @param *curve Target Curve
  * */
 void initCurve(Curve *curve);
 
+/* @brief Recalculates the statistics with a set number of threads
+ *
+ * As initCurve, for callers that already run one Curve per thread. A
+ * memory mapped Curve is scanned one window at a time & keeps its
+ * pending transform, see curve_WindowPoints.
+ * @param *curve Target Curve
+ * @param threads Number of threads, 0 for getStatsThreads
+ * */
+void curve_Analyze(Curve *curve, int threads);
+
+/* @brief Checks the kept up to date statistics against a full rescan
+ *
+ * The Curve is left with the rescanned statistics.
+ * @param *curve Target Curve
+ * @return Returns true if the kept statistics matched the rescan
+ * */
+bool curve_Verify(Curve *curve);
+
 /* @brief Shifts points in the curve
+ *
+ * O(1), see curve_Transform.
+ * @param *curve Target Curve
  * @param shiftX Value to shift X
  * @param shiftY Value to shift Y
  * */
 void mvCurve(Curve *curve, double shiftX, double shiftY);
+
+/* @brief Scales then shifts points in the curve
+ *
+ * The transform is only recorded, statistics are updated analytically
+ * where possible and are otherwise left for a lazy rescan.
+ * @param *curve Target Curve
+ * @param scaleX Value to multiply X by
+ * @param scaleY Value to multiply Y by
+ * @param shiftX Value to shift X
+ * @param shiftY Value to shift Y
+ * */
+void curve_Transform(Curve *curve, double scaleX, double scaleY, double shiftX, double shiftY);
+
+/* @brief Applies the pending transform to the stored coordinates
+ *
+ * The range index is dropped as it describes the old coordinates. A
+ * Curve at a lower precision goes back to double storage, so committing
+ * never rounds the points again.
+ * @param *curve Target Curve
+ * @return Returns false if memory could not be allocated, the Curve is
+ * then left as it was
+ * */
+bool curve_Commit(Curve *curve);
+
+/* @brief Marks the stored coordinates of a Curve as changed
+ *
+ * For code that writes xs, ys or size directly, drops the range index &
+ * marks the statistics for a rescan.
+ * @param *curve Target Curve
+ * */
+void curve_Invalidate(Curve *curve);
+
+/* @brief Exchanges the points & state of two Curves in O(1)
+ * @param *curve First Curve
+ * @param *other Second Curve
+ * */
+void curve_Swap(Curve *curve, Curve *other);
+
+/* @brief Checks if a Curve has a pending transform
+ * @param *curve Target Curve
+ * @return Returns true if the stored coordinates are the points
+ * */
+bool curve_IsCommitted(Curve *curve);
 #endif
@@ -0,0 +1,1751 @@
+#define _POSIX_C_SOURCE 200809L
+#include "curve.h"
+#include "curveio.h"
+#include "perf.h"
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Largest integer every double below can hold exactly */
+#define EXACT_MANTISSA ((uint64_t) 1 << 53)
+/* Significant digits that fit in a 64 bit mantissa */
+#define MAX_DIGITS 19
+/* Bytes buffered by a Writer before they are written */
+#define WRITER_BUFFER_SIZE (1 << 20)
+/* Bytes read at a time by streamStats_Read */
+#define STREAM_BUFFER_SIZE (1 << 16)
+/* Points parsed between two publishes of LoadProgress, a power of two */
+#define PROGRESS_POINTS (1 << 14)
+/* Bytes of text parsed by one thread at a time in a parallel load */
+#define PARSE_CHUNK_SIZE ((size_t) 4 << 20)
+/* Chunks a text file needs before it is parsed by several threads */
+#define PARSE_MIN_CHUNKS 2
+/* Chunks each thread of a parallel load may parse ahead of the appends */
+#define PARSE_CHUNKS_AHEAD 2
+/* Number of cached powers of ten Grisu picks from */
+#define CACHED_POWER_COUNT 87
+/* 32 bit limbs needed to hold 10^348 */
+#define BIG_LIMBS 40
+
+/* Powers of ten that are exact as doubles */
+static const double exactPowers[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* @brief A run of text parsed by one thread of a parallel load
+ * */
+typedef struct
+{
+    const char *begin;
+    const char *end;
+    /* Numbers of the chunk in order, x & y alike */
+    double *values;
+    size_t count;
+    /* Parsing stopped at text that is not a number */
+    bool isStopped;
+    /* Memory for the numbers could not be allocated */
+    bool isFailed;
+    /* Set under the ParseJob lock once the fields above are final */
+    bool isDone;
+}ParseChunk;
+
+/* @brief Chunks of a parallel load & the threads parsing them
+ * */
+typedef struct
+{
+    ParseChunk *chunks;
+    size_t chunkCount;
+    /* Next chunk to parse */
+    size_t nextChunk;
+    /* Chunks appended to the Curve, their numbers are freed */
+    size_t appended;
+    /* Chunks that may be parsed past appended */
+    size_t ahead;
+    /* Set when the threads should stop taking chunks */
+    bool isStopped;
+    pthread_mutex_t lock;
+    /* Signalled when a chunk is done, appended or the job stops */
+    pthread_cond_t changed;
+}ParseJob;
+
+/* @brief Gets a monotonic time stamp
+ * @return Seconds since an unspecified point
+ * */
+static double nowSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* @brief Checks for the whitespace characters scanf skips
+ * */
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/* @brief Checks for a decimal digit
+ * */
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/* @brief Skips whitespace
+ * @return First character that is not whitespace
+ * */
+static const char *skipSpace(const char *begin, const char *end)
+{
+    while (begin < end && isSpace(*begin))
+        begin++;
+    return begin;
+}
+
+/* @brief Parses a number with strtod on a terminated copy
+ * @param *begin First character of the number
+ * @param length Characters to copy
+ * @param *value Parsed value
+ * @return Character after the number or NULL if there is no number
+ * */
+static const char *parseSlow(const char *begin, size_t length, double *value)
+{
+    char buffer[128];
+    char *copy = buffer;
+    char *copyEnd;
+    const char *result = NULL;
+    if (length >= sizeof(buffer))
+    {
+        copy = (char *) malloc(length + 1);
+        if (copy == NULL)
+            return NULL;
+    }
+    memcpy(copy, begin, length);
+    copy[length] = '\0';
+    *value = strtod(copy, &copyEnd);
+    if (copyEnd != copy)
+        result = begin + (copyEnd - copy);
+    if (copy != buffer)
+        free(copy);
+    return result;
+}
+
+/* @brief Checks the byte order of the host
+ * @return Returns true on little-endian hosts
+ * */
+static bool isLittleEndian()
+{
+    uint16_t probe = 1;
+    return *(unsigned char *) &probe == 1;
+}
+
+/* @brief Stores a 32 bit integer little-endian */
+static void putU32(unsigned char *bytes, uint32_t value)
+{
+    int loopVar;
+    for (loopVar = 0; loopVar < 4; loopVar++)
+        bytes[loopVar] = (unsigned char) (value >> (8 * loopVar));
+}
+
+/* @brief Stores a 64 bit integer little-endian */
+static void putU64(unsigned char *bytes, uint64_t value)
+{
+    int loopVar;
+    for (loopVar = 0; loopVar < 8; loopVar++)
+        bytes[loopVar] = (unsigned char) (value >> (8 * loopVar));
+}
+
+/* @brief Stores a double little-endian */
+static void putF64(unsigned char *bytes, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putU64(bytes, bits);
+}
+
+/* @brief Reads a little-endian 32 bit integer */
+static uint32_t getU32(const unsigned char *bytes)
+{
+    uint32_t value = 0;
+    int loopVar;
+    for (loopVar = 3; loopVar >= 0; loopVar--)
+        value = (value << 8) | bytes[loopVar];
+    return value;
+}
+
+/* @brief Reads a little-endian 64 bit integer */
+static uint64_t getU64(const unsigned char *bytes)
+{
+    uint64_t value = 0;
+    int loopVar;
+    for (loopVar = 7; loopVar >= 0; loopVar--)
+        value = (value << 8) | bytes[loopVar];
+    return value;
+}
+
+/* @brief Reads a little-endian double */
+static double getF64(const unsigned char *bytes)
+{
+    uint64_t bits = getU64(bytes);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/* @brief Finds the direction of a Curve the way SequenceCheck does
+ * @param *curve Target Curve
+ * @return Direction of the x values
+ * */
+static CurveDirection curveDirection(Curve *curve)
+{
+    if (curve->size < 2)
+        return DIRECTION_NONE;
+    if (curve_GetAt(curve, 1).x <= curve_GetAt(curve, 0).x)
+        return DIRECTION_DESCENDING;
+    return DIRECTION_ASCENDING;
+}
+
+/* @brief Buffered writer, output is collected and written in big chunks
+ * */
+typedef struct
+{
+    /* Output file descriptor */
+    int fd;
+    /* Name the file is renamed to when durable, NULL otherwise */
+    const char *finalName;
+    /* Name of the file being written */
+    char *fileName;
+    char *buffer;
+    size_t used;
+    /* Bytes written to the file so far */
+    size_t written;
+    /* True once a write has failed */
+    bool failed;
+}Writer;
+
+/* @brief Opens a Writer
+ *
+ * A durable Writer writes to a temporary file next to fileName which is
+ * synced & renamed over fileName when the Writer is closed.
+ * @param *writer Target Writer
+ * @param *fileName Name of the file to write
+ * @param isDurable True for fsync-on-complete & atomic rename
+ * @return Returns false if the file could not be created
+ * */
+static bool writer_Open(Writer *writer, const char *fileName, bool isDurable)
+{
+    mode_t mask;
+    writer->used = 0;
+    writer->written = 0;
+    writer->failed = false;
+    writer->finalName = NULL;
+    writer->fileName = (char *) malloc(strlen(fileName) + 8);
+    writer->buffer = (char *) malloc(WRITER_BUFFER_SIZE);
+    if (writer->fileName == NULL || writer->buffer == NULL)
+    {
+        free(writer->fileName);
+        free(writer->buffer);
+        return false;
+    }
+    if (isDurable)
+    {
+        sprintf(writer->fileName, "%s.XXXXXX", fileName);
+        writer->fd = mkstemp(writer->fileName);
+        if (writer->fd >= 0)
+        {
+            /* mkstemp creates 0600, give the file the usual permissions */
+            mask = umask(0);
+            umask(mask);
+            fchmod(writer->fd, 0666 & ~mask);
+        }
+        writer->finalName = fileName;
+    }
+    else
+    {
+        strcpy(writer->fileName, fileName);
+        writer->fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    }
+    if (writer->fd < 0)
+    {
+        free(writer->fileName);
+        free(writer->buffer);
+        return false;
+    }
+    return true;
+}
+
+/* @brief Writes out everything buffered in a Writer
+ * */
+static void writer_Flush(Writer *writer)
+{
+    size_t done = 0;
+    ssize_t written;
+    while (!writer->failed && done < writer->used)
+    {
+        written = write(writer->fd, writer->buffer + done, writer->used - done);
+        if (written < 0)
+            writer->failed = true;
+        else
+            done += written;
+    }
+    writer->written += done;
+    writer->used = 0;
+}
+
+/* @brief Makes room for bytes in a Writer's buffer
+ * @return Buffer to write up to size bytes to
+ * */
+static char *writer_Reserve(Writer *writer, size_t size)
+{
+    if (WRITER_BUFFER_SIZE - writer->used < size)
+        writer_Flush(writer);
+    return writer->buffer + writer->used;
+}
+
+/* @brief Appends bytes to a Writer
+ * */
+static void writer_Put(Writer *writer, const void *data, size_t size)
+{
+    size_t chunk;
+    while (size > 0)
+    {
+        chunk = WRITER_BUFFER_SIZE - writer->used;
+        if (chunk == 0)
+        {
+            writer_Flush(writer);
+            continue;
+        }
+        if (chunk > size)
+            chunk = size;
+        memcpy(writer->buffer + writer->used, data, chunk);
+        writer->used += chunk;
+        data = (const char *) data + chunk;
+        size -= chunk;
+    }
+}
+
+/* @brief Flushes & closes a Writer, a durable Writer is synced & renamed
+ * @return Returns false if anything failed, the output is then removed
+ * */
+static bool writer_Close(Writer *writer)
+{
+    char *slash;
+    int dirFd;
+    writer_Flush(writer);
+    if (writer->finalName != NULL && !writer->failed && fsync(writer->fd) != 0)
+        writer->failed = true;
+    if (close(writer->fd) != 0)
+        writer->failed = true;
+    if (writer->failed)
+    {
+        unlink(writer->fileName);
+    }
+    else if (writer->finalName != NULL)
+    {
+        if (rename(writer->fileName, writer->finalName) != 0)
+        {
+            writer->failed = true;
+            unlink(writer->fileName);
+        }
+        else
+        {
+            /* Sync the directory so the rename itself survives a crash */
+            slash = strrchr(writer->fileName, '/');
+            if (slash != NULL)
+                slash[1] = '\0';
+            dirFd = open(slash != NULL ? writer->fileName : ".", O_RDONLY);
+            if (dirFd >= 0)
+            {
+                fsync(dirFd);
+                close(dirFd);
+            }
+        }
+    }
+    free(writer->fileName);
+    free(writer->buffer);
+    return !writer->failed;
+}
+
+/* @brief Writes an array of doubles little-endian, value * scale + offset
+ * */
+static void writeDoubles(Writer *writer, const double *values, size_t count, double scale, double offset)
+{
+    unsigned char *bytes;
+    size_t index;
+    if (isLittleEndian() && scale == 1 && offset == 0)
+    {
+        writer_Put(writer, values, count * sizeof(double));
+        return;
+    }
+    for (index = 0; index < count; index++)
+    {
+        bytes = (unsigned char *) writer_Reserve(writer, 8);
+        putF64(bytes, values[index] * scale + offset);
+        writer->used += 8;
+    }
+}
+
+/* @brief Writes one coordinate array of a Curve a window at a time
+ *
+ * Windows of a memory mapped Curve are read ahead & dropped once
+ * written, see curve_WindowPoints. Float & fixed point coordinates
+ * are widened back to double one value at a time.
+ * */
+static void writeCoordinates(Writer *writer, Curve *curve, bool isX)
+{
+    size_t windowPoints = curve_WindowPoints();
+    size_t start, end, ahead, index;
+    double scale = isX ? curve->scaleX : curve->scaleY;
+    double offset = isX ? curve->offsetX : curve->offsetY;
+    unsigned char *bytes;
+    if (curve->storage != PRECISION_DOUBLE)
+    {
+        for (index = 0; index < curve->size; index++)
+        {
+            bytes = (unsigned char *) writer_Reserve(writer, 8);
+            putF64(bytes, (isX ? curve_StoredX(curve, index) : curve_StoredY(curve, index)) * scale + offset);
+            writer->used += 8;
+        }
+        return;
+    }
+    for (start = 0; start < curve->size; start = end)
+    {
+        end = curve->size - start > windowPoints ? start + windowPoints : curve->size;
+        ahead = curve->size - end > windowPoints ? end + windowPoints : curve->size;
+        curve_AdviseWindow(curve, end, ahead, true);
+        writeDoubles(writer, (const double *) (isX ? curve->xs : curve->ys) + start, end - start, scale, offset);
+        curve_AdviseWindow(curve, start, end, false);
+    }
+}
+
+/* @brief Do-it-yourself floating point number, f * 2^e
+ * */
+typedef struct
+{
+    uint64_t f;
+    int e;
+}DiyFp;
+
+/* Normalized powers of ten 10^-348, 10^-340, ... 10^340 used by Grisu */
+static DiyFp cachedPowers[CACHED_POWER_COUNT];
+/* Fills cachedPowers once, even when threads save at the same time */
+static pthread_once_t cachedPowersOnce = PTHREAD_ONCE_INIT;
+
+/* Powers of ten that fit in 64 bits */
+static const uint64_t integerPowers[] =
+{
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+    1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/* @brief Gets the number of significant bits of a big number
+ * @param *limbs 32 bit limbs, least significant first
+ * @param count Number of limbs
+ * */
+static int bigBits(const uint32_t *limbs, int count)
+{
+    int bits;
+    while (count > 0 && limbs[count - 1] == 0)
+        count--;
+    if (count == 0)
+        return 0;
+    bits = 32 * (count - 1);
+    for (uint32_t top = limbs[count - 1]; top != 0; top >>= 1)
+        bits++;
+    return bits;
+}
+
+/* @brief Gets a bit of a big number */
+static int bigBit(const uint32_t *limbs, int bit)
+{
+    return (limbs[bit / 32] >> (bit % 32)) & 1;
+}
+
+/* @brief Compares two big numbers of the same limb count
+ * @return Returns true if a >= b
+ * */
+static bool bigAtLeast(const uint32_t *a, const uint32_t *b, int count)
+{
+    while (count-- > 0)
+    {
+        if (a[count] != b[count])
+            return a[count] > b[count];
+    }
+    return true;
+}
+
+/* @brief Fills cachedPowers with correctly rounded powers of ten
+ *
+ * The powers are derived once with exact big number arithmetic instead
+ * of being kept as a table of magic constants.
+ * */
+static void initCachedPowers()
+{
+    uint32_t power[BIG_LIMBS];
+    uint32_t remainder[BIG_LIMBS];
+    uint64_t carry, mantissa;
+    int index, exponent, bits, bit, loopVar;
+    for (index = 0; index < CACHED_POWER_COUNT; index++)
+    {
+        exponent = -348 + 8 * index;
+        memset(power, 0, sizeof(power));
+        power[0] = 1;
+        for (loopVar = 0; loopVar < (exponent < 0 ? -exponent : exponent); loopVar++)
+        {
+            carry = 0;
+            for (bit = 0; bit < BIG_LIMBS; bit++)
+            {
+                carry += (uint64_t) power[bit] * 10;
+                power[bit] = (uint32_t) carry;
+                carry >>= 32;
+            }
+        }
+        bits = bigBits(power, BIG_LIMBS);
+        if (exponent >= 0)
+        {
+            /* Top 64 bits of 10^k, rounded to nearest */
+            mantissa = 0;
+            for (bit = bits - 1; bit >= bits - 64; bit--)
+                mantissa = (mantissa << 1) | (bit >= 0 ? bigBit(power, bit) : 0);
+            cachedPowers[index].e = bits - 64;
+            if (bits > 64 && bigBit(power, bits - 65))
+                mantissa++;
+        }
+        else
+        {
+            /* 2^(bits + 64) / 10^-k has 65 bits, the first one is always
+             * set, so only the low 64 are kept and rounded away below */
+            memset(remainder, 0, sizeof(remainder));
+            remainder[bits / 32] = (uint32_t) 1 << (bits % 32);
+            mantissa = 0;
+            for (loopVar = 0; loopVar < 65; loopVar++)
+            {
+                mantissa <<= 1;
+                if (bigAtLeast(remainder, power, BIG_LIMBS))
+                {
+                    carry = 0;
+                    for (bit = 0; bit < BIG_LIMBS; bit++)
+                    {
+                        carry = (uint64_t) remainder[bit] - power[bit] - carry;
+                        remainder[bit] = (uint32_t) carry;
+                        carry = (carry >> 32) & 1;
+                    }
+                    mantissa |= 1;
+                }
+                carry = 0;
+                for (bit = 0; bit < BIG_LIMBS; bit++)
+                {
+                    carry |= (uint64_t) remainder[bit] << 1;
+                    remainder[bit] = (uint32_t) carry;
+                    carry >>= 32;
+                }
+            }
+            cachedPowers[index].e = -(bits + 63);
+            carry = mantissa & 1;
+            mantissa = (mantissa >> 1) | ((uint64_t) 1 << 63);
+            mantissa += carry;
+        }
+        if (mantissa == 0)
+        {
+            /* Rounding carried out of the top bit */
+            mantissa = (uint64_t) 1 << 63;
+            cachedPowers[index].e++;
+        }
+        cachedPowers[index].f = mantissa;
+    }
+}
+
+/* @brief Multiplies two DiyFp, keeping the rounded upper 64 bits
+ * */
+static DiyFp diyFp_Multiply(DiyFp x, DiyFp y)
+{
+    const uint64_t mask = 0xFFFFFFFFULL;
+    uint64_t a = x.f >> 32, b = x.f & mask, c = y.f >> 32, d = y.f & mask;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t middle = (bd >> 32) + (ad & mask) + (bc & mask) + (1ULL << 31);
+    DiyFp result;
+    result.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    result.e = x.e + y.e + 64;
+    return result;
+}
+
+/* @brief Shifts a DiyFp until its top bit is set
+ * */
+static DiyFp diyFp_Normalize(DiyFp x)
+{
+    while (!(x.f & ((uint64_t) 1 << 63)))
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+/* @brief Moves the last digit of a Grisu result closer to the value
+ * */
+static void grisuRound(char *digits, int length, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t distance)
+{
+    while (rest < distance && delta - rest >= tenKappa
+        && (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance))
+    {
+        digits[length - 1]--;
+        rest += tenKappa;
+    }
+}
+
+/* @brief Grisu2, shortest digits of a positive finite double
+ *
+ * Florian Loitsch, "Printing Floating-Point Numbers Quickly and
+ * Accurately with Integers". The digits always read back to the same
+ * double and are the shortest possible for nearly every input.
+ * @param value Value to convert, positive and finite
+ * @param *digits Receives the digits, not terminated
+ * @param *exponent Receives the decimal exponent of the last digit
+ * @return Number of digits
+ * */
+static int grisu2(double value, char *digits, int *exponent)
+{
+    const uint64_t hiddenBit = (uint64_t) 1 << 52;
+    uint64_t bits, significand, p1, p2, delta, tmp;
+    int biasedExponent, kappa, length = 0, index, digit;
+    double dk;
+    DiyFp v, plus, minus, cached, w, wPlus, wMinus, one, distance;
+    memcpy(&bits, &value, sizeof(bits));
+    biasedExponent = (int) ((bits >> 52) & 0x7FF);
+    significand = bits & (hiddenBit - 1);
+    if (biasedExponent != 0)
+    {
+        v.f = significand + hiddenBit;
+        v.e = biasedExponent - 1075;
+    }
+    else
+    {
+        v.f = significand;
+        v.e = -1074;
+    }
+    /* Boundaries half way to the neighbouring doubles */
+    plus.f = (v.f << 1) + 1;
+    plus.e = v.e - 1;
+    while (!(plus.f & (hiddenBit << 1)))
+    {
+        plus.f <<= 1;
+        plus.e--;
+    }
+    plus.f <<= 10;
+    plus.e -= 10;
+    if (v.f == hiddenBit)
+    {
+        minus.f = (v.f << 2) - 1;
+        minus.e = v.e - 2;
+    }
+    else
+    {
+        minus.f = (v.f << 1) - 1;
+        minus.e = v.e - 1;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+    /* Scale by a cached power so the product exponent lands in [-60, -32] */
+    dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+    index = (int) dk;
+    if (dk - index > 0.0)
+        index++;
+    index = (index >> 3) + 1;
+    *exponent = -(-348 + index * 8);
+    cached = cachedPowers[index];
+    w = diyFp_Multiply(diyFp_Normalize(v), cached);
+    wPlus = diyFp_Multiply(plus, cached);
+    wMinus = diyFp_Multiply(minus, cached);
+    wMinus.f++;
+    wPlus.f--;
+    /* Generate digits of wPlus until they are inside the boundaries */
+    delta = wPlus.f - wMinus.f;
+    one.f = (uint64_t) 1 << -wPlus.e;
+    one.e = wPlus.e;
+    distance.f = wPlus.f - w.f;
+    p1 = wPlus.f >> -one.e;
+    p2 = wPlus.f & (one.f - 1);
+    kappa = 1;
+    while (kappa < 10 && p1 >= integerPowers[kappa])
+        kappa++;
+    while (kappa > 0)
+    {
+        digit = (int) (p1 / integerPowers[kappa - 1]);
+        p1 %= integerPowers[kappa - 1];
+        if (digit != 0 || length != 0)
+            digits[length++] = (char) ('0' + digit);
+        kappa--;
+        tmp = (p1 << -one.e) + p2;
+        if (tmp <= delta)
+        {
+            *exponent += kappa;
+            grisuRound(digits, length, delta, tmp, integerPowers[kappa] << -one.e, distance.f);
+            return length;
+        }
+    }
+    for (;;)
+    {
+        p2 *= 10;
+        delta *= 10;
+        digit = (int) (p2 >> -one.e);
+        if (digit != 0 || length != 0)
+            digits[length++] = (char) ('0' + digit);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta)
+        {
+            *exponent += kappa;
+            grisuRound(digits, length, delta, p2, one.f,
+                distance.f * (-kappa < 20 ? integerPowers[-kappa] : 0));
+            return length;
+        }
+    }
+}
+
+size_t formatDouble(char *buffer, double value)
+{
+    char digits[32];
+    char *out = buffer;
+    int length, exponent, point, loopVar;
+    if (value != value)
+        return sprintf(buffer, "nan");
+    if (signbit(value))
+    {
+        *out++ = '-';
+        value = -value;
+    }
+    if (value == 0)
+    {
+        *out++ = '0';
+        return out - buffer;
+    }
+    if (isinf(value))
+        return out - buffer + sprintf(out, "inf");
+    pthread_once(&cachedPowersOnce, initCachedPowers);
+    length = grisu2(value, digits, &exponent);
+    /* Position of the decimal point relative to the first digit */
+    point = length + exponent;
+    if (exponent >= 0 && point <= 21)
+    {
+        /* Integer, 1234e3 -> 1234000 */
+        memcpy(out, digits, length);
+        out += length;
+        for (loopVar = 0; loopVar < exponent; loopVar++)
+            *out++ = '0';
+    }
+    else if (point > 0 && point <= 21)
+    {
+        /* 1234e-2 -> 12.34 */
+        memcpy(out, digits, point);
+        out += point;
+        *out++ = '.';
+        memcpy(out, digits + point, length - point);
+        out += length - point;
+    }
+    else if (point > -6 && point <= 0)
+    {
+        /* 1234e-6 -> 0.001234 */
+        *out++ = '0';
+        *out++ = '.';
+        for (loopVar = point; loopVar < 0; loopVar++)
+            *out++ = '0';
+        memcpy(out, digits, length);
+        out += length;
+    }
+    else
+    {
+        /* 1234e30 -> 1.234e33 */
+        *out++ = digits[0];
+        if (length > 1)
+        {
+            *out++ = '.';
+            memcpy(out, digits + 1, length - 1);
+            out += length - 1;
+        }
+        out += sprintf(out, "e%d", point - 1);
+    }
+    return out - buffer;
+}
+
+void loadProgress_Init(LoadProgress *progress)
+{
+    __atomic_store_n(&progress->totalBytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&progress->bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&progress->points, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&progress->isCancelled, false, __ATOMIC_RELAXED);
+}
+
+void loadProgress_Cancel(LoadProgress *progress)
+{
+    __atomic_store_n(&progress->isCancelled, true, __ATOMIC_RELAXED);
+}
+
+void loadProgress_Get(LoadProgress *progress, size_t *totalBytes, size_t *bytes, size_t *points)
+{
+    *totalBytes = __atomic_load_n(&progress->totalBytes, __ATOMIC_RELAXED);
+    *bytes = __atomic_load_n(&progress->bytes, __ATOMIC_RELAXED);
+    *points = __atomic_load_n(&progress->points, __ATOMIC_RELAXED);
+}
+
+/* @brief Publishes the position of a load
+ * @return Returns false if the load has been cancelled
+ * */
+static bool loadProgress_Publish(LoadProgress *progress, size_t bytes, size_t points)
+{
+    __atomic_store_n(&progress->bytes, bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&progress->points, points, __ATOMIC_RELAXED);
+    return !__atomic_load_n(&progress->isCancelled, __ATOMIC_RELAXED);
+}
+
+void sequence_Init(SequenceCheck *check)
+{
+    check->count = 0;
+    check->lastX = 0;
+    check->gotDirection = false;
+    check->typeDirection = false;
+}
+
+bool sequence_Accept(SequenceCheck *check, double x)
+{
+    if (check->count > 0)
+    {
+        if (!check->gotDirection)
+        {
+            check->gotDirection = true;
+            if (x <= check->lastX)
+                check->typeDirection = true;
+            else
+                check->typeDirection = false;
+        }
+        if (!(x <= check->lastX && check->typeDirection)
+            && !(x >= check->lastX && !check->typeDirection))
+            return false;
+    }
+    check->lastX = x;
+    check->count++;
+    return true;
+}
+
+const char *parseDouble(const char *begin, const char *end, double *value)
+{
+    const char *p = begin;
+    const char *digitStart;
+    bool negative = false;
+    bool anyDigit = false;
+    bool dropped = false;
+    bool expNegative;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    int expValue;
+    double result;
+    if (p < end && (*p == '+' || *p == '-'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    digitStart = p;
+    /* Hexadecimal, infinity & NaN are rare enough to leave to strtod */
+    if (p + 1 < end && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+        return parseSlow(begin, end - begin < 127 ? end - begin : 127, value);
+    while (p < end && isDigit(*p))
+    {
+        anyDigit = true;
+        /* Leading zeros are not significant */
+        if (mantissa != 0 || *p != '0')
+        {
+            if (digits < MAX_DIGITS)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits++;
+            }
+            else
+            {
+                exponent++;
+                if (*p != '0')
+                    dropped = true;
+            }
+        }
+        p++;
+    }
+    if (p < end && *p == '.')
+    {
+        p++;
+        while (p < end && isDigit(*p))
+        {
+            anyDigit = true;
+            if (mantissa == 0 && *p == '0')
+            {
+                exponent--;
+            }
+            else if (digits < MAX_DIGITS)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits++;
+                exponent--;
+            }
+            else if (*p != '0')
+            {
+                dropped = true;
+            }
+            p++;
+        }
+    }
+    if (!anyDigit)
+    {
+        if (p == digitStart)
+            return parseSlow(begin, end - begin < 127 ? end - begin : 127, value);
+        return NULL;
+    }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        expNegative = false;
+        if (q < end && (*q == '+' || *q == '-'))
+        {
+            expNegative = *q == '-';
+            q++;
+        }
+        if (q < end && isDigit(*q))
+        {
+            expValue = 0;
+            while (q < end && isDigit(*q))
+            {
+                if (expValue < 100000)
+                    expValue = expValue * 10 + (*q - '0');
+                q++;
+            }
+            exponent += expNegative ? -expValue : expValue;
+            p = q;
+        }
+    }
+    if (mantissa == 0)
+    {
+        *value = negative ? -0.0 : 0.0;
+        return p;
+    }
+    while (mantissa > EXACT_MANTISSA && mantissa % 10 == 0)
+    {
+        mantissa /= 10;
+        exponent++;
+    }
+    /* Clinger's fast path, an exact mantissa times an exact power of
+     * ten is rounded once and so matches strtod */
+    if (!dropped && mantissa <= EXACT_MANTISSA)
+    {
+        if (exponent >= -22 && exponent <= 22)
+        {
+            result = (double) mantissa;
+            if (exponent < 0)
+                result /= exactPowers[-exponent];
+            else
+                result *= exactPowers[exponent];
+            *value = negative ? -result : result;
+            return p;
+        }
+        if (exponent > 22 && exponent <= 22 + 15)
+        {
+            result = (double) mantissa * exactPowers[exponent - 22];
+            if (result < (double) EXACT_MANTISSA)
+            {
+                result *= exactPowers[22];
+                *value = negative ? -result : result;
+                return p;
+            }
+        }
+    }
+    return parseSlow(begin, p - begin, value);
+}
+
+/* @brief Appends the "x y" pairs of a run of text to a Curve, one thread
+ * @param *check Sequence of the points before
+ * @param **position Filled with where parsing stopped
+ * @return Load status
+ * */
+static LoadStatus appendText(Curve *curve, const char *data, const char *end, SequenceCheck *check,
+                             LoadProgress *progress, const char **position)
+{
+    LoadStatus status = LOAD_OK;
+    const char *p = data, *q;
+    double x, y;
+    size_t startSize = curve->size;
+    size_t parsed = 0;
+    while (p < end)
+    {
+        q = parseDouble(skipSpace(p, end), end, &x);
+        if (q == NULL)
+            break;
+        p = parseDouble(skipSpace(q, end), end, &y);
+        if (p == NULL)
+            break;
+        if (!sequence_Accept(check, x))
+        {
+            status = LOAD_SEQUENCE;
+            break;
+        }
+        if (!curve_Append(curve, x, y))
+        {
+            status = LOAD_NOMEMORY;
+            break;
+        }
+        if (progress != NULL && (++parsed & (PROGRESS_POINTS - 1)) == 0
+            && !loadProgress_Publish(progress, p - data, curve->size - startSize))
+        {
+            status = LOAD_CANCELLED;
+            break;
+        }
+    }
+    *position = p;
+    return status;
+}
+
+/* @brief Parses one chunk, a worker of parseJob_Run
+ *
+ * Numbers are kept as one run, pairs may cross chunks.
+ * */
+static void parseChunk(ParseChunk *chunk)
+{
+    const char *p = chunk->begin;
+    double *values;
+    size_t capacity = (chunk->end - chunk->begin) / 8 + 16;
+    chunk->count = 0;
+    chunk->isStopped = false;
+    chunk->isFailed = false;
+    chunk->values = (double *) malloc(capacity * sizeof(double));
+    if (chunk->values == NULL)
+    {
+        chunk->isFailed = true;
+        return;
+    }
+    while (true)
+    {
+        p = skipSpace(p, chunk->end);
+        if (p == chunk->end)
+            return;
+        if (chunk->count == capacity)
+        {
+            capacity *= 2;
+            values = (double *) realloc(chunk->values, capacity * sizeof(double));
+            if (values == NULL)
+            {
+                chunk->isFailed = true;
+                return;
+            }
+            chunk->values = values;
+        }
+        p = parseDouble(p, chunk->end, &chunk->values[chunk->count]);
+        if (p == NULL)
+        {
+            chunk->isStopped = true;
+            return;
+        }
+        chunk->count++;
+    }
+}
+
+/* @brief Parses chunks in file order until the job stops, thread of a
+ * parallel load
+ * */
+static void *parseJob_Run(void *argument)
+{
+    ParseJob *job = (ParseJob *) argument;
+    ParseChunk *chunk;
+    while (true)
+    {
+        pthread_mutex_lock(&job->lock);
+        /* Stay a bounded number of chunks ahead of the appends */
+        while (!job->isStopped && job->nextChunk < job->chunkCount && job->nextChunk >= job->appended + job->ahead)
+            pthread_cond_wait(&job->changed, &job->lock);
+        if (job->isStopped || job->nextChunk >= job->chunkCount)
+        {
+            pthread_mutex_unlock(&job->lock);
+            return NULL;
+        }
+        chunk = &job->chunks[job->nextChunk++];
+        pthread_mutex_unlock(&job->lock);
+        parseChunk(chunk);
+        pthread_mutex_lock(&job->lock);
+        chunk->isDone = true;
+        pthread_cond_broadcast(&job->changed);
+        pthread_mutex_unlock(&job->lock);
+    }
+}
+
+/* @brief As appendText, with the text parsed by several threads
+ *
+ * The text is cut into chunks at newlines & parsed concurrently, the
+ * calling thread appends the chunks in file order with the same
+ * sequence check, so points, statistics & errors match appendText.
+ * Falls back to appendText if the threads could not be started.
+ * @return Load status
+ * */
+static LoadStatus appendTextParallel(Curve *curve, const char *data, const char *end, int threads,
+                                     SequenceCheck *check, LoadProgress *progress, const char **position)
+{
+    LoadStatus status = LOAD_OK;
+    ParseJob job;
+    ParseChunk *chunk;
+    pthread_t *workers;
+    const char *begin = data, *split;
+    double x = 0;
+    size_t index, value, startSize = curve->size, parsed = 0;
+    bool hasX = false;
+    int started = 0, loopVar;
+    *position = data;
+    job.chunkCount = ((size_t) (end - data) + PARSE_CHUNK_SIZE - 1) / PARSE_CHUNK_SIZE;
+    job.chunks = (ParseChunk *) calloc(job.chunkCount, sizeof(ParseChunk));
+    workers = (pthread_t *) malloc(threads * sizeof(pthread_t));
+    if (job.chunks == NULL || workers == NULL)
+    {
+        free(job.chunks);
+        free(workers);
+        return appendText(curve, data, end, check, progress, position);
+    }
+    /* Chunks end after a newline, so no number is cut in two */
+    for (index = 0; index < job.chunkCount; index++)
+    {
+        split = end;
+        if (index + 1 < job.chunkCount && data + (index + 1) * PARSE_CHUNK_SIZE > begin)
+        {
+            split = (const char *) memchr(data + (index + 1) * PARSE_CHUNK_SIZE, '\n',
+                                          end - (data + (index + 1) * PARSE_CHUNK_SIZE));
+            split = split == NULL ? end : split + 1;
+        }
+        else if (index + 1 < job.chunkCount)
+        {
+            split = begin;
+        }
+        job.chunks[index].begin = begin;
+        job.chunks[index].end = split;
+        begin = split;
+    }
+    job.nextChunk = 0;
+    job.appended = 0;
+    job.ahead = (size_t) threads * PARSE_CHUNKS_AHEAD;
+    job.isStopped = false;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.changed, NULL);
+    for (loopVar = 0; loopVar < threads; loopVar++)
+    {
+        if (pthread_create(&workers[started], NULL, parseJob_Run, &job) == 0)
+            started++;
+    }
+    for (index = 0; index < job.chunkCount && started > 0 && status == LOAD_OK; index++)
+    {
+        chunk = &job.chunks[index];
+        pthread_mutex_lock(&job.lock);
+        while (!chunk->isDone)
+            pthread_cond_wait(&job.changed, &job.lock);
+        pthread_mutex_unlock(&job.lock);
+        if (chunk->isFailed)
+        {
+            status = LOAD_NOMEMORY;
+            break;
+        }
+        /* Pair the numbers as appendText does, a lone x waits for the
+         * next chunk */
+        for (value = 0; value < chunk->count && status == LOAD_OK; value++)
+        {
+            if (!hasX)
+            {
+                x = chunk->values[value];
+                hasX = true;
+                continue;
+            }
+            hasX = false;
+            if (!sequence_Accept(check, x))
+                status = LOAD_SEQUENCE;
+            else if (!curve_Append(curve, x, chunk->values[value]))
+                status = LOAD_NOMEMORY;
+            else if (progress != NULL && (++parsed & (PROGRESS_POINTS - 1)) == 0
+                     && !loadProgress_Publish(progress, chunk->begin - data, curve->size - startSize))
+                status = LOAD_CANCELLED;
+        }
+        *position = chunk->end;
+        if (chunk->isStopped)
+            break;
+        free(chunk->values);
+        chunk->values = NULL;
+        pthread_mutex_lock(&job.lock);
+        job.appended = index + 1;
+        pthread_cond_broadcast(&job.changed);
+        pthread_mutex_unlock(&job.lock);
+    }
+    pthread_mutex_lock(&job.lock);
+    job.isStopped = true;
+    pthread_cond_broadcast(&job.changed);
+    pthread_mutex_unlock(&job.lock);
+    for (loopVar = 0; loopVar < started; loopVar++)
+        pthread_join(workers[loopVar], NULL);
+    pthread_cond_destroy(&job.changed);
+    pthread_mutex_destroy(&job.lock);
+    for (index = 0; index < job.chunkCount; index++)
+        free(job.chunks[index].values);
+    free(job.chunks);
+    free(workers);
+    if (started == 0)
+        return appendText(curve, data, end, check, progress, position);
+    return status;
+}
+
+/* @brief curve_LoadText, publishing to progress if it is not NULL
+ *
+ * Files of several chunks are parsed by the given number of threads.
+ * */
+static LoadStatus loadText(Curve *curve, const char *fileName, LoadInfo *info, LoadProgress *progress, int threads)
+{
+    LoadStatus status = LOAD_OK;
+    SequenceCheck check;
+    struct stat fileStat;
+    const char *data = NULL;
+    const char *position;
+    double startTime = nowSeconds();
+    size_t startSize = curve->size;
+    int fd;
+    fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+        return LOAD_NOFILE;
+    if (fstat(fd, &fileStat) < 0)
+    {
+        close(fd);
+        return LOAD_NOFILE;
+    }
+    if (fileStat.st_size > 0)
+    {
+        data = (const char *) mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            return LOAD_NOFILE;
+        }
+        posix_madvise((void *) data, fileStat.st_size, POSIX_MADV_SEQUENTIAL);
+    }
+    close(fd);
+    if (progress != NULL)
+        __atomic_store_n(&progress->totalBytes, (size_t) fileStat.st_size, __ATOMIC_RELAXED);
+    sequence_Init(&check);
+    if (curve->size > 0)
+        sequence_Accept(&check, curve_GetAt(curve, curve->size - 1).x);
+    if (threads > 1 && (size_t) fileStat.st_size > PARSE_MIN_CHUNKS * PARSE_CHUNK_SIZE)
+        status = appendTextParallel(curve, data, data + fileStat.st_size, threads, &check, progress, &position);
+    else
+        status = appendText(curve, data, data + fileStat.st_size, &check, progress, &position);
+    if (progress != NULL)
+        loadProgress_Publish(progress, position == NULL ? (size_t) fileStat.st_size : (size_t) (position - data),
+                             curve->size - startSize);
+    if (data != NULL)
+        munmap((void *) data, fileStat.st_size);
+    if (info != NULL)
+    {
+        info->bytes = fileStat.st_size;
+        info->points = curve->size - startSize;
+        info->seconds = nowSeconds() - startTime;
+    }
+    return status;
+}
+
+LoadStatus curve_LoadText(Curve *curve, const char *fileName, LoadInfo *info)
+{
+    return loadText(curve, fileName, info, NULL, getStatsThreads());
+}
+
+void streamStats_Init(StreamStats *stats)
+{
+    stats->count = 0;
+    stats->lastPoint.x = 0;
+    stats->lastPoint.y = 0;
+    stats->lowPoint = stats->lastPoint;
+    stats->highPoint = stats->lastPoint;
+    stats->length = 0;
+    stats->area = 0;
+}
+
+void streamStats_Add(StreamStats *stats, double x, double y)
+{
+    Point point;
+    point.x = x;
+    point.y = y;
+    if (stats->count == 0)
+    {
+        stats->lowPoint = point;
+        stats->highPoint = point;
+    }
+    else
+    {
+        stats->length += calcPointLength(&stats->lastPoint, &point);
+        stats->area += calcPointArea(&stats->lastPoint, &point);
+        if (point.y < stats->lowPoint.y)
+            stats->lowPoint = point;
+        if (point.y > stats->highPoint.y)
+            stats->highPoint = point;
+    }
+    stats->lastPoint = point;
+    stats->count++;
+}
+
+/* @brief Receives the numbers read by readStream
+ * @return LOAD_OK to keep reading, else the status to stop with
+ * */
+typedef LoadStatus (*NumberSink)(void *context, double value);
+
+/* @brief Reads whitespace separated numbers from a file descriptor
+ *
+ * Input is read through a fixed buffer, reading stops at the end of input
+ * or the first text that is not a number.
+ * @param fd File descriptor to read until end of input
+ * @param sink Called with every number in order
+ * @param *context Passed to sink
+ * @param *bytes Filled with the bytes read
+ * @return LOAD_OK or the status that stopped reading
+ * */
+static LoadStatus readStream(int fd, NumberSink sink, void *context, size_t *bytes)
+{
+    LoadStatus status = LOAD_OK;
+    char *buffer;
+    const char *p, *q, *end, *limit;
+    double value;
+    size_t used = 0;
+    ssize_t got;
+    bool isEnd = false;
+    bool isStopped = false;
+    *bytes = 0;
+    buffer = (char *) malloc(STREAM_BUFFER_SIZE);
+    if (buffer == NULL)
+        return LOAD_NOMEMORY;
+    while (!isEnd && !isStopped)
+    {
+        got = read(fd, buffer + used, STREAM_BUFFER_SIZE - used);
+        if (got < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            status = LOAD_NOFILE;
+            break;
+        }
+        if (got == 0)
+            isEnd = true;
+        used += got;
+        *bytes += got;
+        end = buffer + used;
+        /* A number may continue in the next read, only parse up to the
+         * last whitespace until the input ends */
+        limit = end;
+        if (!isEnd)
+        {
+            while (limit > buffer && !isSpace(limit[-1]))
+                limit--;
+            if (limit == buffer)
+            {
+                /* A single word filling the buffer is not a number */
+                if (used == STREAM_BUFFER_SIZE)
+                    break;
+                continue;
+            }
+        }
+        p = skipSpace(buffer, limit);
+        while (p < limit)
+        {
+            q = parseDouble(p, limit, &value);
+            if (q == NULL)
+            {
+                isStopped = true;
+                break;
+            }
+            p = skipSpace(q, limit);
+            status = sink(context, value);
+            if (status != LOAD_OK)
+            {
+                isStopped = true;
+                break;
+            }
+        }
+        memmove(buffer, limit, end - limit);
+        used = end - limit;
+    }
+    free(buffer);
+    return status;
+}
+
+/* @brief State of streamStats_Read between numbers
+ * */
+typedef struct
+{
+    StreamStats *stats;
+    SequenceCheck check;
+    double x;
+    /* True if x is waiting for its y */
+    bool gotX;
+}StreamReader;
+
+/* @brief NumberSink pairing numbers into points for StreamStats
+ * */
+static LoadStatus streamReader_Accept(void *context, double value)
+{
+    StreamReader *reader = (StreamReader *) context;
+    if (!reader->gotX)
+    {
+        reader->x = value;
+        reader->gotX = true;
+        return LOAD_OK;
+    }
+    reader->gotX = false;
+    if (!sequence_Accept(&reader->check, reader->x))
+        return LOAD_SEQUENCE;
+    streamStats_Add(reader->stats, reader->x, value);
+    return LOAD_OK;
+}
+
+LoadStatus streamStats_Read(StreamStats *stats, int fd, LoadInfo *info)
+{
+    StreamReader reader;
+    LoadStatus status;
+    double startTime = nowSeconds();
+    size_t startCount = stats->count;
+    size_t bytes;
+    reader.stats = stats;
+    reader.gotX = false;
+    sequence_Init(&reader.check);
+    if (stats->count > 0)
+        sequence_Accept(&reader.check, stats->lastPoint.x);
+    status = readStream(fd, streamReader_Accept, &reader, &bytes);
+    perf_Stop(PERF_LOAD, startTime, bytes, stats->count - startCount);
+    if (info != NULL)
+    {
+        info->bytes = bytes;
+        info->points = stats->count - startCount;
+        info->seconds = nowSeconds() - startTime;
+    }
+    return status;
+}
+
+/* @brief Growing array filled by readNumbers
+ * */
+typedef struct
+{
+    double *values;
+    size_t count;
+    size_t capacity;
+}NumberArray;
+
+/* @brief NumberSink appending to a NumberArray
+ * */
+static LoadStatus numberArray_Accept(void *context, double value)
+{
+    NumberArray *array = (NumberArray *) context;
+    double *values;
+    if (array->count == array->capacity)
+    {
+        array->capacity = array->capacity > 0 ? array->capacity * 2 : 1024;
+        values = (double *) realloc(array->values, array->capacity * sizeof(double));
+        if (values == NULL)
+            return LOAD_NOMEMORY;
+        array->values = values;
+    }
+    array->values[array->count++] = value;
+    return LOAD_OK;
+}
+
+LoadStatus readNumbers(int fd, double **values, size_t *count)
+{
+    NumberArray array = {NULL, 0, 0};
+    LoadStatus status;
+    size_t bytes;
+    status = readStream(fd, numberArray_Accept, &array, &bytes);
+    *values = array.values;
+    *count = array.count;
+    return status;
+}
+
+double loadInfo_Throughput(LoadInfo *info)
+{
+    if (info->seconds <= 0)
+        return 0;
+    return info->bytes / (1024.0 * 1024.0) / info->seconds;
+}
+
+LoadStatus curve_LoadBinary(Curve *curve, const char *fileName, LoadInfo *info)
+{
+    struct stat fileStat;
+    unsigned char *data;
+    double startTime = nowSeconds();
+    double *xs, *ys;
+    uint64_t count;
+    size_t index;
+    int fd;
+    fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+        return LOAD_NOFILE;
+    if (fstat(fd, &fileStat) < 0)
+    {
+        close(fd);
+        return LOAD_NOFILE;
+    }
+    if (fileStat.st_size < NCB_HEADER_SIZE)
+    {
+        close(fd);
+        return LOAD_FORMAT;
+    }
+    /* Private & writable so the Curve can be modified in place, pages are
+     * only copied once they are written */
+    data = (unsigned char *) mmap(NULL, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return LOAD_NOFILE;
+    count = getU64(data + 8);
+    if (memcmp(data, NCB_MAGIC, 4) != 0 || getU32(data + 4) != NCB_VERSION
+        || count > (uint64_t) (fileStat.st_size - NCB_HEADER_SIZE) / 16)
+    {
+        munmap(data, fileStat.st_size);
+        return LOAD_FORMAT;
+    }
+    xs = (double *) (data + NCB_HEADER_SIZE);
+    ys = xs + count;
+    if (isLittleEndian())
+    {
+        curve_Map(curve, data, fileStat.st_size, xs, ys, count);
+    }
+    else
+    {
+        curve_Clear(curve);
+        if (!curve_Reserve(curve, count))
+        {
+            munmap(data, fileStat.st_size);
+            return LOAD_NOMEMORY;
+        }
+        for (index = 0; index < count; index++)
+        {
+            ((double *) curve->xs)[index] = getF64((unsigned char *) (xs + index));
+            ((double *) curve->ys)[index] = getF64((unsigned char *) (ys + index));
+        }
+        curve->size = count;
+    }
+    curve->length = getF64(data + 24);
+    curve->area = getF64(data + 32);
+    curve->lowPoint.x = getF64(data + 40);
+    curve->lowPoint.y = getF64(data + 48);
+    curve->highPoint.x = getF64(data + 56);
+    curve->highPoint.y = getF64(data + 64);
+    curve->isAnalyzed = true;
+    if (!isLittleEndian())
+        munmap(data, fileStat.st_size);
+    if (info != NULL)
+    {
+        info->bytes = fileStat.st_size;
+        info->points = count;
+        info->seconds = nowSeconds() - startTime;
+    }
+    return LOAD_OK;
+}
+
+/* @brief curve_LoadFileProgress, parsing text on the given number of threads
+ * */
+static LoadStatus loadFile(Curve *curve, const char *fileName, LoadInfo *info, LoadProgress *progress, int threads)
+{
+    LoadInfo fileInfo = {0, 0, 0};
+    LoadStatus status;
+    CurvePrecision precision;
+    double step;
+    char magic[4];
+    size_t got;
+    double startTime = perf_Start();
+    FILE *inputFile = fopen(fileName, "rb");
+    if (inputFile == NULL)
+        return LOAD_NOFILE;
+    got = fread(magic, 1, sizeof(magic), inputFile);
+    fclose(inputFile);
+    if (got == sizeof(magic) && memcmp(magic, NCB_MAGIC, 4) == 0)
+    {
+        /* Mapping is O(1), progress jumps straight to the end */
+        status = curve_LoadBinary(curve, fileName, &fileInfo);
+        if (progress != NULL)
+        {
+            __atomic_store_n(&progress->totalBytes, fileInfo.bytes, __ATOMIC_RELAXED);
+            loadProgress_Publish(progress, fileInfo.bytes, fileInfo.points);
+        }
+    }
+    else
+    {
+        status = loadText(curve, fileName, &fileInfo, progress, threads);
+    }
+    precision = getLoadPrecision(&step);
+    if ((status == LOAD_OK || status == LOAD_SEQUENCE) && !curve_Quantize(curve, precision, step))
+        status = LOAD_RANGE;
+    perf_Stop(PERF_LOAD, startTime, fileInfo.bytes, fileInfo.points);
+    if (info != NULL)
+        *info = fileInfo;
+    return status;
+}
+
+LoadStatus curve_LoadFile(Curve *curve, const char *fileName, LoadInfo *info)
+{
+    return loadFile(curve, fileName, info, NULL, getStatsThreads());
+}
+
+LoadStatus curve_LoadFileThreads(Curve *curve, const char *fileName, LoadInfo *info, int threads)
+{
+    return loadFile(curve, fileName, info, NULL, threads);
+}
+
+LoadStatus curve_LoadFileProgress(Curve *curve, const char *fileName, LoadInfo *info, LoadProgress *progress)
+{
+    return loadFile(curve, fileName, info, progress, getStatsThreads());
+}
+
+/* @brief Closes the Writer of a save & records the save
+ * @return Returns false if anything failed
+ * */
+static bool saveClose(Writer *writer, double startTime, size_t points)
+{
+    bool isSaved = writer_Close(writer);
+    perf_Stop(PERF_SAVE, startTime, writer->written, points);
+    return isSaved;
+}
+
+/* @brief Fills the header of a binary curve file
+ * */
+static void putHeader(unsigned char *header, size_t count, CurveDirection direction, double length, double area,
+                      Point lowPoint, Point highPoint)
+{
+    memset(header, 0, NCB_HEADER_SIZE);
+    memcpy(header, NCB_MAGIC, 4);
+    putU32(header + 4, NCB_VERSION);
+    putU64(header + 8, count);
+    putU32(header + 16, direction);
+    putF64(header + 24, length);
+    putF64(header + 32, area);
+    putF64(header + 40, lowPoint.x);
+    putF64(header + 48, lowPoint.y);
+    putF64(header + 56, highPoint.x);
+    putF64(header + 64, highPoint.y);
+}
+
+bool curve_SaveBinary(Curve *curve, const char *fileName, bool isDurable)
+{
+    unsigned char header[NCB_HEADER_SIZE];
+    Writer writer;
+    double startTime = perf_Start();
+    if (!curve->isAnalyzed)
+        initCurve(curve);
+    putHeader(header, curve->size, curveDirection(curve), curve->length, curve->area, curve->lowPoint,
+              curve->highPoint);
+    if (!writer_Open(&writer, fileName, isDurable))
+        return false;
+    writer_Put(&writer, header, sizeof(header));
+    /* A pending transform is folded in while writing */
+    writeCoordinates(&writer, curve, true);
+    writeCoordinates(&writer, curve, false);
+    return saveClose(&writer, startTime, curve->size);
+}
+
+bool curve_SaveText(Curve *curve, const char *fileName, bool isDurable)
+{
+    Writer writer;
+    char *out;
+    size_t index, windowPoints, ahead;
+    Point point;
+    double startTime = perf_Start();
+    if (!writer_Open(&writer, fileName, isDurable))
+        return false;
+    windowPoints = curve_WindowPoints();
+    for (index = 0; index < curve->size; index++)
+    {
+        /* Walk a memory mapped Curve a window at a time */
+        if (index % windowPoints == 0)
+        {
+            if (index > 0)
+                curve_AdviseWindow(curve, index - windowPoints, index, false);
+            ahead = curve->size - index > windowPoints ? index + windowPoints : curve->size;
+            curve_AdviseWindow(curve, index, ahead, true);
+        }
+        point = curve_GetAt(curve, index);
+        out = writer_Reserve(&writer, 2 * FORMAT_DOUBLE_SIZE + 2);
+        out += formatDouble(out, point.x);
+        *out++ = ' ';
+        out += formatDouble(out, point.y);
+        *out++ = '\n';
+        writer.used = out - writer.buffer;
+    }
+    return saveClose(&writer, startTime, curve->size);
+}
+
+bool packedCurve_SaveBinary(PackedCurve *packed, const char *fileName, bool isDurable)
+{
+    unsigned char header[NCB_HEADER_SIZE];
+    double xs[PACKED_BLOCK_POINTS];
+    double ys[PACKED_BLOCK_POINTS];
+    Writer writer;
+    CurveDirection direction = DIRECTION_NONE;
+    size_t block, count;
+    double startTime = perf_Start();
+    if (!packed->isAnalyzed)
+        packedCurve_Analyze(packed);
+    if (packed->count >= 2)
+    {
+        packedCurve_Decode(packed, 0, xs, ys);
+        direction = xs[1] <= xs[0] ? DIRECTION_DESCENDING : DIRECTION_ASCENDING;
+    }
+    putHeader(header, packed->count, direction, packed->length, packed->area, packed->lowPoint,
+              packed->highPoint);
+    if (!writer_Open(&writer, fileName, isDurable))
+        return false;
+    writer_Put(&writer, header, sizeof(header));
+    /* Every block is decoded once for the x array & once for the y array */
+    for (block = 0; block < packed->blockCount; block++)
+    {
+        count = packedCurve_Decode(packed, block, xs, ys);
+        writeDoubles(&writer, xs, count, 1, 0);
+    }
+    for (block = 0; block < packed->blockCount; block++)
+    {
+        count = packedCurve_Decode(packed, block, xs, ys);
+        writeDoubles(&writer, ys, count, 1, 0);
+    }
+    return saveClose(&writer, startTime, packed->count);
+}
+
+bool packedCurve_SaveText(PackedCurve *packed, const char *fileName, bool isDurable)
+{
+    double xs[PACKED_BLOCK_POINTS];
+    double ys[PACKED_BLOCK_POINTS];
+    Writer writer;
+    char *out;
+    size_t block, count, index;
+    double startTime = perf_Start();
+    if (!writer_Open(&writer, fileName, isDurable))
+        return false;
+    for (block = 0; block < packed->blockCount; block++)
+    {
+        count = packedCurve_Decode(packed, block, xs, ys);
+        for (index = 0; index < count; index++)
+        {
+            out = writer_Reserve(&writer, 2 * FORMAT_DOUBLE_SIZE + 2);
+            out += formatDouble(out, xs[index]);
+            *out++ = ' ';
+            out += formatDouble(out, ys[index]);
+            *out++ = '\n';
+            writer.used = out - writer.buffer;
+        }
+    }
+    return saveClose(&writer, startTime, packed->count);
+}
+
+bool isBinaryName(const char *fileName)
+{
+    size_t length = strlen(fileName);
+    return length >= 4 && strcmp(fileName + length - 4, ".ncb") == 0;
+}
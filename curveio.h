@@ -0,0 +1,325 @@
+#include "curve.h"
+#include "packed.h"
+#ifndef CURVEIO_H
+    #define CURVEIO_H
+#include <stddef.h>
+#include <stdbool.h>
+
+/* @brief Result of loading a Curve from a file
+ * */
+typedef enum
+{
+    /* Every coordinate in the file was loaded */
+    LOAD_OK,
+    /* File could not be opened or read */
+    LOAD_NOFILE,
+    /* Memory for the points could not be allocated */
+    LOAD_NOMEMORY,
+    /* X values are not sequential, points before the offending one are kept */
+    LOAD_SEQUENCE,
+    /* Binary file has a bad header or an unsupported version */
+    LOAD_FORMAT,
+    /* Stopped by loadProgress_Cancel, points read so far are kept */
+    LOAD_CANCELLED,
+    /* A coordinate does not fit the load precision, points are kept as read.
+     * Memory mapped .ncb files are not quantized, so never give this */
+    LOAD_RANGE
+}LoadStatus;
+
+/* @brief Binary curve file (.ncb) layout, every field little-endian
+ *
+ * Offset  Size  Field
+ * 0       4     Magic "NCB1"
+ * 4       4     Format version, NCB_VERSION
+ * 8       8     Point count n
+ * 16      4     Direction, see CurveDirection
+ * 20      4     Reserved, 0
+ * 24      8     Length of the curve
+ * 32      8     Area under the curve
+ * 40      16    Lowest point x, y
+ * 56      16    Highest point x, y
+ * 72      8n    X coordinates
+ * 72+8n   8n    Y coordinates
+ * */
+#define NCB_MAGIC "NCB1"
+#define NCB_VERSION 1
+#define NCB_HEADER_SIZE 72
+
+/* Largest number of characters formatDouble writes */
+#define FORMAT_DOUBLE_SIZE 32
+
+/* @brief Direction of x values stored in a binary curve file
+ * */
+typedef enum
+{
+    /* Fewer than two points */
+    DIRECTION_NONE,
+    /* X values grow or stay equal */
+    DIRECTION_ASCENDING,
+    /* X values shrink or stay equal */
+    DIRECTION_DESCENDING
+}CurveDirection;
+
+/* @brief Statistics about a finished load
+ * */
+typedef struct
+{
+    /* Bytes of the file that were read */
+    size_t bytes;
+    /* Points appended to the Curve */
+    size_t points;
+    /* Wall time taken in seconds */
+    double seconds;
+}LoadInfo;
+
+/* @brief Progress of a load, shared with other threads
+ *
+ * The loading thread publishes its position every few thousand points
+ * and stops at the next publish once the load is cancelled. Use the
+ * loadProgress functions to read & write the fields from any thread.
+ * */
+typedef struct
+{
+    /* Bytes of the file, known once it is opened */
+    size_t totalBytes;
+    /* Bytes parsed so far */
+    size_t bytes;
+    /* Points appended so far */
+    size_t points;
+    /* Set to stop the load */
+    bool isCancelled;
+}LoadProgress;
+
+/* @brief Resets LoadProgress before a new load
+ * @param *progress Target LoadProgress
+ * */
+void loadProgress_Init(LoadProgress *progress);
+
+/* @brief Asks the load using a LoadProgress to stop, safe from any thread
+ * @param *progress Target LoadProgress
+ * */
+void loadProgress_Cancel(LoadProgress *progress);
+
+/* @brief Reads the published position of a load, safe from any thread
+ * @param *progress Target LoadProgress
+ * @param *totalBytes Bytes of the file, 0 until it is opened
+ * @param *bytes Bytes parsed so far
+ * @param *points Points appended so far
+ * */
+void loadProgress_Get(LoadProgress *progress, size_t *totalBytes, size_t *bytes, size_t *points);
+
+/* @brief Tracks the direction of x values while points are read
+ *
+ * The direction is taken from the first two x values, every following x
+ * must keep going the same way or stay equal.
+ * */
+typedef struct
+{
+    /* Number of accepted x values */
+    size_t count;
+    /* Last accepted x value */
+    double lastX;
+    /* True once the direction is known */
+    bool gotDirection;
+    /* True: Smaller False: Larger */
+    bool typeDirection;
+}SequenceCheck;
+
+/* @brief Resets a SequenceCheck before a new run of points
+ * @param *check Target SequenceCheck
+ * */
+void sequence_Init(SequenceCheck *check);
+
+/* @brief Checks that x continues the sequence and records it
+ * @param *check Target SequenceCheck
+ * @param x Next x value
+ * @return Returns false if x breaks the sequence
+ * */
+bool sequence_Accept(SequenceCheck *check, double x);
+
+/* @brief Statistics of a stream of points, kept without the points
+ *
+ * Holds the same values initCurve calculates, only the previous point and
+ * the running sums are remembered.
+ * */
+typedef struct
+{
+    /* Number of points added */
+    size_t count;
+    /* Last point added */
+    Point lastPoint;
+    Point lowPoint;
+    Point highPoint;
+    double length;
+    double area;
+}StreamStats;
+
+/* @brief Resets StreamStats before a new stream of points
+ * @param *stats Target StreamStats
+ * */
+void streamStats_Init(StreamStats *stats);
+
+/* @brief Adds the next point of a stream
+ * @param *stats Target StreamStats
+ * @param x Value of x
+ * @param y Value of y
+ * */
+void streamStats_Add(StreamStats *stats, double x, double y);
+
+/* @brief Reads "x y" pairs from a file descriptor into StreamStats
+ *
+ * Works on pipes & FIFOs, input is read through a fixed buffer so memory
+ * use does not depend on the number of points. Reading stops at the end
+ * of input or the first text that is not a number, x values must be
+ * sequential as for curve_LoadText.
+ * @param *stats Target StreamStats, points are added
+ * @param fd File descriptor to read until end of input
+ * @param *info Filled with load statistics, may be NULL
+ * @return Load status, LOAD_SEQUENCE keeps the points before the offending one
+ * */
+LoadStatus streamStats_Read(StreamStats *stats, int fd, LoadInfo *info);
+
+/* @brief Reads whitespace separated numbers from a file descriptor
+ *
+ * Works on pipes & FIFOs, reading stops at the end of input or the first
+ * text that is not a number.
+ * @param fd File descriptor to read until end of input
+ * @param **values Filled with a new array of the numbers, free it after use
+ * @param *count Filled with the number of numbers
+ * @return Load status, the numbers read so far are kept on failure
+ * */
+LoadStatus readNumbers(int fd, double **values, size_t *count);
+
+/* @brief Parses a decimal floating point number, independent of locale
+ *
+ * Produces the same value as strtod, numbers that cannot be converted
+ * exactly with double arithmetic are handed to strtod.
+ * @param *begin First character of the number
+ * @param *end End of the readable characters
+ * @param *value Parsed value
+ * @return Character after the number or NULL if there is no number
+ * */
+const char *parseDouble(const char *begin, const char *end, double *value);
+
+/* @brief Loads whitespace separated "x y" pairs from a text file
+ *
+ * The file is memory mapped and parsed in place, loading stops at the
+ * first text that is not a number.
+ * @param *curve Target Curve, points are appended
+ * @param *fileName Name of the file to load
+ * @param *info Filled with load statistics, may be NULL
+ * @return Load status
+ * */
+LoadStatus curve_LoadText(Curve *curve, const char *fileName, LoadInfo *info);
+
+/* @brief Loads a binary curve file by memory mapping it
+ *
+ * Statistics are read from the header, the points are not touched until
+ * they are used.
+ * @param *curve Target Curve, cleared first
+ * @param *fileName Name of the file to load
+ * @param *info Filled with load statistics, may be NULL
+ * @return Load status
+ * */
+LoadStatus curve_LoadBinary(Curve *curve, const char *fileName, LoadInfo *info);
+
+/* @brief Loads a binary or text curve file, whichever the file holds
+ *
+ * The points are then rounded to getLoadPrecision, see curve_Quantize.
+ * A memory mapped .ncb file keeps its doubles, quantizing would copy
+ * every page of the mapping.
+ * @param *curve Target Curve
+ * @param *fileName Name of the file to load
+ * @param *info Filled with load statistics, may be NULL
+ * @return Load status
+ * */
+LoadStatus curve_LoadFile(Curve *curve, const char *fileName, LoadInfo *info);
+
+/* @brief As curve_LoadFile, parsing a large text file on a given number of
+ * threads instead of getStatsThreads
+ *
+ * Callers already running on a pool of threads load with 1, so every
+ * task does not start a pool of its own.
+ * @param *curve Target Curve
+ * @param *fileName Name of the file to load
+ * @param *info Filled with load statistics, may be NULL
+ * @param threads Number of parse threads, 1 for the calling thread only
+ * @return Load status
+ * */
+LoadStatus curve_LoadFileThreads(Curve *curve, const char *fileName, LoadInfo *info, int threads);
+
+/* @brief As curve_LoadFile, publishing progress & checking for cancellation
+ *
+ * Meant to run on a background thread while another thread watches
+ * progress, see AsyncLoad.
+ * @param *curve Target Curve
+ * @param *fileName Name of the file to load
+ * @param *info Filled with load statistics, may be NULL
+ * @param *progress Progress shared with other threads, may be NULL
+ * @return Load status
+ * */
+LoadStatus curve_LoadFileProgress(Curve *curve, const char *fileName, LoadInfo *info, LoadProgress *progress);
+
+/* @brief Saves a Curve as a binary curve file
+ * @param *curve Target Curve, analyzed first if needed
+ * @param *fileName Name of the file to write
+ * @param isDurable True to write a temporary file, fsync it and rename it
+ * over fileName so a crash never leaves a partial file
+ * @return Returns false if the file could not be written
+ * */
+bool curve_SaveBinary(Curve *curve, const char *fileName, bool isDurable);
+
+/* @brief Saves a Curve as "x y" lines of text
+ *
+ * Every coordinate is written with formatDouble, so the file reads back
+ * to the same doubles, and output goes through a large buffer.
+ * @param *curve Target Curve
+ * @param *fileName Name of the file to write
+ * @param isDurable True to write a temporary file, fsync it and rename it
+ * over fileName so a crash never leaves a partial file
+ * @return Returns false if the file could not be written
+ * */
+bool curve_SaveText(Curve *curve, const char *fileName, bool isDurable);
+
+/* @brief Saves a PackedCurve as a binary curve file
+ *
+ * Blocks are decoded one at a time while writing, the points are never
+ * unpacked.
+ * @param *packed Target PackedCurve, analyzed first if needed
+ * @param *fileName Name of the file to write
+ * @param isDurable As curve_SaveBinary
+ * @return Returns false if the file could not be written
+ * */
+bool packedCurve_SaveBinary(PackedCurve *packed, const char *fileName, bool isDurable);
+
+/* @brief Saves a PackedCurve as "x y" lines of text, as curve_SaveText
+ * @param *packed Target PackedCurve
+ * @param *fileName Name of the file to write
+ * @param isDurable As curve_SaveText
+ * @return Returns false if the file could not be written
+ * */
+bool packedCurve_SaveText(PackedCurve *packed, const char *fileName, bool isDurable);
+
+/* @brief Formats a double with the shortest digits that read back exactly
+ *
+ * Uses Grisu2, the result always reads back to the same double and is
+ * the shortest possible for nearly every value.
+ * @param *buffer Output, at least FORMAT_DOUBLE_SIZE characters, not
+ * terminated
+ * @param value Value to format
+ * @return Number of characters written
+ * */
+size_t formatDouble(char *buffer, double value);
+
+/* @brief Checks if a file name has the binary curve extension
+ * @param *fileName Target file name
+ * @return Returns true for names ending in .ncb
+ * */
+bool isBinaryName(const char *fileName);
+
+/* @brief Converts a load throughput to MB/s
+ * @param *info Finished load statistics
+ * @return Megabytes read per second
+ * */
+double loadInfo_Throughput(LoadInfo *info);
+#endif
@@ -0,0 +1,208 @@
+#include "curve.h"
+#include "interp.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define INTERP_X86
+    #include <immintrin.h>
+#endif
+
+/* Queries located before each interpolation pass */
+#define INTERP_BATCH 4096
+/* Binary searches run side by side */
+#define INTERP_GROUP 16
+
+/* @brief Interpolates one query on segment i, from point i to i + 1
+ *
+ * The segment ends are transformed as curve_GetAt gives them.
+ * */
+static double lerpSegment(const Curve *curve, int64_t segment, double query)
+{
+    double x0 = curve_StoredX(curve, segment) * curve->scaleX + curve->offsetX;
+    double x1 = curve_StoredX(curve, segment + 1) * curve->scaleX + curve->offsetX;
+    double y0 = curve_StoredY(curve, segment) * curve->scaleY + curve->offsetY;
+    double y1 = curve_StoredY(curve, segment + 1) * curve->scaleY + curve->offsetY;
+    double dx = x1 - x0;
+    if (dx == 0)
+        return y1;
+    return y0 + (y1 - y0) * ((query - x0) / dx);
+}
+
+/* @brief Reference interpolation kernel
+ * */
+static void lerpScalar(const Curve *curve, const int64_t *segments, const double *queries, size_t count, double *results)
+{
+    size_t index;
+    for (index = 0; index < count; index++)
+        results[index] = lerpSegment(curve, segments[index], queries[index]);
+}
+
+#ifdef INTERP_X86
+/* @brief AVX2 kernel, gathers the segment ends of four queries per step
+ * and rounds exactly as lerpScalar
+ * */
+__attribute__((target("avx2")))
+static void lerpAvx2(const Curve *curve, const int64_t *segments, const double *queries, size_t count, double *results)
+{
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d scaleX = _mm256_set1_pd(curve->scaleX);
+    const __m256d scaleY = _mm256_set1_pd(curve->scaleY);
+    const __m256d offsetX = _mm256_set1_pd(curve->offsetX);
+    const __m256d offsetY = _mm256_set1_pd(curve->offsetY);
+    const double *xs = (const double *) curve->xs;
+    const double *ys = (const double *) curve->ys;
+    __m256i segment;
+    __m256d x0, x1, y0, y1, query, dx, result;
+    size_t index;
+    for (index = 0; index + 4 <= count; index += 4)
+    {
+        segment = _mm256_loadu_si256((const __m256i *) (segments + index));
+        x0 = _mm256_i64gather_pd(xs, segment, 8);
+        x1 = _mm256_i64gather_pd(xs + 1, segment, 8);
+        y0 = _mm256_i64gather_pd(ys, segment, 8);
+        y1 = _mm256_i64gather_pd(ys + 1, segment, 8);
+        x0 = _mm256_add_pd(_mm256_mul_pd(x0, scaleX), offsetX);
+        x1 = _mm256_add_pd(_mm256_mul_pd(x1, scaleX), offsetX);
+        y0 = _mm256_add_pd(_mm256_mul_pd(y0, scaleY), offsetY);
+        y1 = _mm256_add_pd(_mm256_mul_pd(y1, scaleY), offsetY);
+        query = _mm256_loadu_pd(queries + index);
+        dx = _mm256_sub_pd(x1, x0);
+        result = _mm256_add_pd(y0, _mm256_mul_pd(_mm256_sub_pd(y1, y0),
+            _mm256_div_pd(_mm256_sub_pd(query, x0), dx)));
+        result = _mm256_blendv_pd(result, y1, _mm256_cmp_pd(dx, zero, _CMP_EQ_OQ));
+        _mm256_storeu_pd(results + index, result);
+    }
+    lerpScalar(curve, segments + index, queries + index, count - index, results + index);
+}
+#endif
+
+/* @brief Interpolates a batch of located queries
+ * */
+static void lerpBatch(const Curve *curve, const int64_t *segments, const double *queries, size_t count, double *results)
+{
+#ifdef INTERP_X86
+    /* The gathers read doubles, float & fixed point curves go scalar */
+    if (curve->storage == PRECISION_DOUBLE && __builtin_cpu_supports("avx2"))
+    {
+        lerpAvx2(curve, segments, queries, count, results);
+        return;
+    }
+#endif
+    lerpScalar(curve, segments, queries, count, results);
+}
+
+/* @brief Finds the segments of a group of keys by binary search
+ *
+ * Keys are transformed x values times direction, so they grow along the
+ * curve, and must not be before the first point. The searches run in lockstep
+ * without branches so the cache misses of the group overlap.
+ * @param *segments Filled with the last point with a key up to each key,
+ * at most count - 2
+ * */
+static void searchSegments(const Curve *curve, double direction, const double *keys, int64_t *segments)
+{
+    const char *xs = (const char *) curve->xs;
+    size_t width = curve_CoordinateBytes(curve);
+    size_t count = curve->size;
+    size_t bases[INTERP_GROUP];
+    size_t length = count;
+    size_t half;
+    int group;
+    for (group = 0; group < INTERP_GROUP; group++)
+        bases[group] = 0;
+    while (length > 1)
+    {
+        half = length / 2;
+        length -= half;
+        for (group = 0; group < INTERP_GROUP; group++)
+        {
+            bases[group] += (curve_StoredX(curve, bases[group] + half) * curve->scaleX + curve->offsetX) * direction
+                            <= keys[group] ? half : 0;
+            /* Start loading the next probe while the group goes on */
+            __builtin_prefetch(xs + (bases[group] + length / 2) * width);
+        }
+    }
+    for (group = 0; group < INTERP_GROUP; group++)
+        segments[group] = bases[group] < count - 2 ? (int64_t) bases[group] : (int64_t) count - 2;
+}
+
+void curve_Interpolate(Curve *curve, const double *queries, size_t count, double *results)
+{
+    int64_t segments[INTERP_BATCH + INTERP_GROUP];
+    double keys[INTERP_BATCH + INTERP_GROUP];
+    double direction, firstKey, lastKey;
+    size_t index, start, batch, loopVar;
+    int64_t segment = 0;
+    bool isSorted = true;
+    Point point;
+    if (curve->size < 2)
+    {
+        /* No segments, only the x of a single point has a y */
+        for (index = 0; index < count; index++)
+        {
+            results[index] = NAN;
+            if (curve->size == 1)
+            {
+                point = curve_GetAt(curve, 0);
+                if (queries[index] == point.x)
+                    results[index] = point.y;
+            }
+        }
+        return;
+    }
+    /* The pending transform is applied on the fly, committing would
+     * rewrite every point & dirty a memory mapped Curve */
+    firstKey = curve_GetAt(curve, 0).x;
+    lastKey = curve_GetAt(curve, curve->size - 1).x;
+    direction = lastKey >= firstKey ? 1 : -1;
+    firstKey *= direction;
+    lastKey *= direction;
+    for (index = 1; index < count && isSorted; index++)
+        isSorted = queries[index] * direction >= queries[index - 1] * direction;
+    for (start = 0; start < count; start += batch)
+    {
+        batch = count - start < INTERP_BATCH ? count - start : INTERP_BATCH;
+        /* Queries outside the curve are located at the first point so the
+         * kernel reads valid memory, their results are replaced below */
+        for (loopVar = 0; loopVar < batch; loopVar++)
+        {
+            keys[loopVar] = queries[start + loopVar] * direction;
+            if (!(keys[loopVar] >= firstKey && keys[loopVar] <= lastKey))
+                keys[loopVar] = firstKey;
+        }
+        if (isSorted)
+        {
+            /* Merge walk, the segment only moves forward */
+            for (loopVar = 0; loopVar < batch; loopVar++)
+            {
+                while ((size_t) segment + 2 < curve->size
+                       && (curve_StoredX(curve, segment + 1) * curve->scaleX + curve->offsetX) * direction <= keys[loopVar])
+                    segment++;
+                segments[loopVar] = segment;
+            }
+        }
+        else
+        {
+            for (loopVar = batch; loopVar % INTERP_GROUP != 0; loopVar++)
+                keys[loopVar] = firstKey;
+            for (loopVar = 0; loopVar < batch; loopVar += INTERP_GROUP)
+                searchSegments(curve, direction, keys + loopVar, segments + loopVar);
+        }
+        lerpBatch(curve, segments, queries + start, batch, results + start);
+        for (loopVar = 0; loopVar < batch; loopVar++)
+        {
+            if (!(queries[start + loopVar] * direction >= firstKey && queries[start + loopVar] * direction <= lastKey))
+                results[start + loopVar] = NAN;
+        }
+    }
+}
+
+const char *curve_InterpolateKernel()
+{
+#ifdef INTERP_X86
+    if (__builtin_cpu_supports("avx2"))
+        return "avx2";
+#endif
+    return "scalar";
+}
@@ -0,0 +1,24 @@
+#include "curve.h"
+#ifndef INTERP_H
+    #define INTERP_H
+#include <stddef.h>
+
+/* @brief Evaluates a Curve at many x values by linear interpolation
+ *
+ * Queries sorted along the curve are answered by one merge walk, O(n + m),
+ * other queries by binary search. Segments are found first, then y values
+ * are interpolated a batch at a time with the widest vector kernel the
+ * processor supports. Where x repeats, the last point with that x is used.
+ * @param *curve Target Curve, left untouched, a pending transform is
+ * applied to each point read
+ * @param *queries X values to evaluate
+ * @param count Number of queries
+ * @param *results Y values, NaN for x outside the curve
+ * */
+void curve_Interpolate(Curve *curve, const double *queries, size_t count, double *results);
+
+/* @brief Gets the name of the kernel curve_Interpolate uses
+ * @return "avx2" or "scalar"
+ * */
+const char *curve_InterpolateKernel();
+#endif
@@ -0,0 +1,114 @@
+#define _POSIX_C_SOURCE 200809L
+#include "loader.h"
+#include "perf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+struct AsyncLoad
+{
+    char *fileName;
+    /* Receives the points, swapped into the caller's Curve at the end */
+    Curve *staging;
+    LoadProgress progress;
+    LoadInfo info;
+    LoadStatus status;
+    double startTime;
+    pthread_t thread;
+    /* True once the thread has stored status & info */
+    bool isDone;
+    /* True once the thread has been joined */
+    bool isJoined;
+};
+
+/* @brief Thread body, runs the load
+ * */
+static void *asyncLoad_Run(void *argument)
+{
+    AsyncLoad *load = (AsyncLoad *) argument;
+    load->status = curve_LoadFileProgress(load->staging, load->fileName, &load->info, &load->progress);
+    __atomic_store_n(&load->isDone, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* @brief Waits for the loading thread once
+ * */
+static void asyncLoad_Join(AsyncLoad *load)
+{
+    if (load->isJoined)
+        return;
+    pthread_join(load->thread, NULL);
+    load->isJoined = true;
+}
+
+AsyncLoad *mkAsyncLoad(const char *fileName)
+{
+    AsyncLoad *load = (AsyncLoad *) malloc(sizeof(AsyncLoad));
+    size_t length = strlen(fileName) + 1;
+    if (load == NULL)
+        return NULL;
+    load->fileName = (char *) malloc(length);
+    load->staging = mkCurve();
+    if (load->fileName == NULL || load->staging == NULL)
+    {
+        free(load->fileName);
+        rmCurve(load->staging);
+        free(load);
+        return NULL;
+    }
+    memcpy(load->fileName, fileName, length);
+    loadProgress_Init(&load->progress);
+    load->info.bytes = 0;
+    load->info.points = 0;
+    load->info.seconds = 0;
+    load->status = LOAD_OK;
+    load->startTime = perf_Start();
+    load->isDone = false;
+    load->isJoined = false;
+    if (pthread_create(&load->thread, NULL, asyncLoad_Run, load) != 0)
+    {
+        free(load->fileName);
+        rmCurve(load->staging);
+        free(load);
+        return NULL;
+    }
+    return load;
+}
+
+void rmAsyncLoad(AsyncLoad *load)
+{
+    if (load == NULL)
+        return;
+    asyncLoad_Cancel(load);
+    asyncLoad_Join(load);
+    free(load->fileName);
+    rmCurve(load->staging);
+    free(load);
+}
+
+void asyncLoad_Cancel(AsyncLoad *load)
+{
+    loadProgress_Cancel(&load->progress);
+}
+
+bool asyncLoad_IsDone(AsyncLoad *load)
+{
+    return __atomic_load_n(&load->isDone, __ATOMIC_ACQUIRE);
+}
+
+void asyncLoad_Progress(AsyncLoad *load, size_t *totalBytes, LoadInfo *info)
+{
+    loadProgress_Get(&load->progress, totalBytes, &info->bytes, &info->points);
+    info->seconds = perf_Start() - load->startTime;
+}
+
+LoadStatus asyncLoad_Finish(AsyncLoad *load, Curve *curve, LoadInfo *info)
+{
+    asyncLoad_Join(load);
+    if (load->status != LOAD_NOFILE && load->status != LOAD_FORMAT && load->status != LOAD_CANCELLED
+        && load->status != LOAD_RANGE)
+        curve_Swap(curve, load->staging);
+    if (info != NULL)
+        *info = load->info;
+    return load->status;
+}
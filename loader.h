@@ -0,0 +1,55 @@
+#include "curve.h"
+#include "curveio.h"
+#ifndef LOADER_H
+    #define LOADER_H
+#include <stdbool.h>
+
+/* @brief A curve file loading on a background thread
+ *
+ * Points go into a staging Curve owned by the AsyncLoad, so the Curve
+ * in use is untouched until asyncLoad_Finish swaps them in. Cancelled or
+ * failed loads free the staging Curve with rmAsyncLoad.
+ * */
+typedef struct AsyncLoad AsyncLoad;
+
+/* @brief Starts loading a curve file on a new thread
+ * @param *fileName Name of the file to load
+ * @return Memory of new AsyncLoad or NULL if it could not be started
+ * */
+AsyncLoad *mkAsyncLoad(const char *fileName);
+
+/* @brief Cancels a load if it is running, waits for its thread & frees it
+ * @param *load Target AsyncLoad, may be NULL
+ * */
+void rmAsyncLoad(AsyncLoad *load);
+
+/* @brief Asks a load to stop, it ends with LOAD_CANCELLED
+ * @param *load Target AsyncLoad
+ * */
+void asyncLoad_Cancel(AsyncLoad *load);
+
+/* @brief Checks if the loading thread has finished
+ * @param *load Target AsyncLoad
+ * @return Returns true once the result is ready
+ * */
+bool asyncLoad_IsDone(AsyncLoad *load);
+
+/* @brief Reads the position of a load
+ * @param *load Target AsyncLoad
+ * @param *totalBytes Bytes of the file, 0 until it is opened
+ * @param *info Bytes & points so far & seconds since the start
+ * */
+void asyncLoad_Progress(AsyncLoad *load, size_t *totalBytes, LoadInfo *info);
+
+/* @brief Waits for a load & swaps its points into a Curve
+ *
+ * Points are swapped in unless the file could not be read, had a bad
+ * format, did not fit the load precision or the load was cancelled, the
+ * previous points of the Curve are freed with the AsyncLoad.
+ * @param *load Target AsyncLoad
+ * @param *curve Curve to receive the points
+ * @param *info Filled with load statistics, may be NULL
+ * @return Load status
+ * */
+LoadStatus asyncLoad_Finish(AsyncLoad *load, Curve *curve, LoadInfo *info);
+#endif
@@ -0,0 +1,702 @@
+#include "packed.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Words the bit stream starts with */
+#define PACKED_MIN_WORDS 256
+/* Most decimal digits of a decimal column */
+#define PACKED_MAX_DIGITS 15
+/* Integers of a decimal column stay below this, so doubles hold them */
+#define EXACT_INTEGER 9007199254740992.0
+
+/* @brief Kind of the x or y values of a block, 2 bits
+ *
+ * Each value is turned into an integer code of its kind, codes are then
+ * stored encoded or, when that would be larger, raw.
+ * */
+typedef enum
+{
+    /* Bit pattern of the double */
+    COLUMN_DOUBLE,
+    /* Bit pattern of the float, every value is exactly a float */
+    COLUMN_SINGLE,
+    /* Integer n of n / 10^digits */
+    COLUMN_DECIMAL,
+    /* Integer n of n * fixedStep that fits 32 bits */
+    COLUMN_FIXED
+}ColumnKind;
+
+/* @brief How a column turns values into codes
+ * */
+typedef struct
+{
+    ColumnKind kind;
+    int digits;
+    double step;
+}Column;
+
+/* Powers of ten that are exact as doubles */
+static const double powers[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+/* @brief Appends bits to the bit stream of a PackedCurve
+ * */
+typedef struct
+{
+    PackedCurve *packed;
+    /* Words allocated in packed->words */
+    size_t capacity;
+    /* Bits written */
+    size_t bits;
+    bool failed;
+}BitWriter;
+
+/* @brief Reads bits from the bit stream of a PackedCurve
+ * */
+typedef struct
+{
+    const uint64_t *words;
+    /* Next bit to read */
+    size_t bit;
+}BitReader;
+
+/* region: Bit streams */
+
+/* @brief Writes the low count bits of value, count from 1 to 64
+ *
+ * Words are assigned as the stream reaches them, so growing the stream
+ * only touches the memory that is written.
+ * */
+static void bitWriter_Put(BitWriter *writer, uint64_t value, int count)
+{
+    PackedCurve *packed = writer->packed;
+    uint64_t *words;
+    size_t word = writer->bits / 64;
+    int used = (int) (writer->bits % 64);
+    int room = 64 - used;
+    if (writer->failed)
+        return;
+    if (word + 1 >= writer->capacity)
+    {
+        words = (uint64_t *) realloc(packed->words, 2 * writer->capacity * sizeof(uint64_t));
+        if (words == NULL)
+        {
+            writer->failed = true;
+            return;
+        }
+        packed->words = words;
+        writer->capacity *= 2;
+    }
+    if (count < 64)
+        value &= ((uint64_t) 1 << count) - 1;
+    if (used == 0)
+        packed->words[word] = 0;
+    if (count <= room)
+    {
+        packed->words[word] |= value << (room - count);
+    }
+    else
+    {
+        packed->words[word] |= value >> (count - room);
+        packed->words[word + 1] = value << (64 - (count - room));
+    }
+    writer->bits += count;
+}
+
+/* @brief Drops every bit written after a position
+ * */
+static void bitWriter_Rewind(BitWriter *writer, size_t bits)
+{
+    if (writer->failed)
+        return;
+    if (bits % 64 != 0)
+        writer->packed->words[bits / 64] &= ~(((uint64_t) 1 << (64 - bits % 64)) - 1);
+    writer->bits = bits;
+}
+
+/* @brief Reads count bits, count from 1 to 64
+ * */
+static uint64_t bitReader_Get(BitReader *reader, int count)
+{
+    size_t word = reader->bit / 64;
+    int used = (int) (reader->bit % 64);
+    uint64_t value = reader->words[word] << used;
+    if (used + count > 64)
+        value |= reader->words[word + 1] >> (64 - used);
+    reader->bit += count;
+    return count < 64 ? value >> (64 - count) : value;
+}
+
+/* @brief Reads a single bit
+ * */
+static bool bitReader_Bit(BitReader *reader)
+{
+    bool bit = (reader->words[reader->bit / 64] >> (63 - reader->bit % 64)) & 1;
+    reader->bit++;
+    return bit;
+}
+/* endregion */
+
+/* region: Encoding */
+
+static uint64_t doubleBits(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bitsDouble(uint64_t bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/* @brief Writes a delta of delta, short codes for small values
+ *
+ * '0' for 0, '10' + 7 bits, '110' + 9 bits, '1110' + 12 bits or
+ * '1111' + 64 bits, of the zigzag encoded value.
+ * */
+static void putDelta(BitWriter *writer, uint64_t delta)
+{
+    uint64_t zigzag = (delta << 1) ^ (uint64_t) ((int64_t) delta >> 63);
+    if (zigzag == 0)
+    {
+        bitWriter_Put(writer, 0, 1);
+    }
+    else if (zigzag < (1 << 7))
+    {
+        bitWriter_Put(writer, 2, 2);
+        bitWriter_Put(writer, zigzag, 7);
+    }
+    else if (zigzag < (1 << 9))
+    {
+        bitWriter_Put(writer, 6, 3);
+        bitWriter_Put(writer, zigzag, 9);
+    }
+    else if (zigzag < (1 << 12))
+    {
+        bitWriter_Put(writer, 14, 4);
+        bitWriter_Put(writer, zigzag, 12);
+    }
+    else
+    {
+        bitWriter_Put(writer, 15, 4);
+        bitWriter_Put(writer, zigzag, 64);
+    }
+}
+
+/* @brief Reads a value written by putDelta
+ * */
+static uint64_t getDelta(BitReader *reader)
+{
+    uint64_t zigzag;
+    if (!bitReader_Bit(reader))
+        return 0;
+    if (!bitReader_Bit(reader))
+        zigzag = bitReader_Get(reader, 7);
+    else if (!bitReader_Bit(reader))
+        zigzag = bitReader_Get(reader, 9);
+    else if (!bitReader_Bit(reader))
+        zigzag = bitReader_Get(reader, 12);
+    else
+        zigzag = bitReader_Get(reader, 64);
+    return (zigzag >> 1) ^ (0 - (zigzag & 1));
+}
+
+/* @brief Gorilla state of the y values of a block
+ * */
+typedef struct
+{
+    uint64_t last;
+    /* Meaningful bit window of the last XOR, leading = 64 before one */
+    int leading;
+    int trailing;
+}XorState;
+
+/* @brief Writes y as its XOR with the previous y
+ *
+ * '0' if equal, '10' + the bits inside the previous window if the XOR
+ * fits it, else '11' + 6 bits leading zeros + 6 bits length - 1 + bits.
+ * */
+static void putXor(BitWriter *writer, XorState *state, uint64_t bits)
+{
+    uint64_t xor = bits ^ state->last;
+    int leading, trailing;
+    state->last = bits;
+    if (xor == 0)
+    {
+        bitWriter_Put(writer, 0, 1);
+        return;
+    }
+    leading = __builtin_clzll(xor);
+    trailing = __builtin_ctzll(xor);
+    if (state->leading < 64 && leading >= state->leading && trailing >= state->trailing)
+    {
+        bitWriter_Put(writer, 2, 2);
+        bitWriter_Put(writer, xor >> state->trailing, 64 - state->leading - state->trailing);
+        return;
+    }
+    bitWriter_Put(writer, 3, 2);
+    bitWriter_Put(writer, leading, 6);
+    bitWriter_Put(writer, 63 - leading - trailing, 6);
+    bitWriter_Put(writer, xor >> trailing, 64 - leading - trailing);
+    state->leading = leading;
+    state->trailing = trailing;
+}
+
+/* @brief Reads a y written by putXor
+ * */
+static uint64_t getXor(BitReader *reader, XorState *state)
+{
+    int length;
+    if (!bitReader_Bit(reader))
+        return state->last;
+    if (bitReader_Bit(reader))
+    {
+        state->leading = (int) bitReader_Get(reader, 6);
+        length = (int) bitReader_Get(reader, 6) + 1;
+        state->trailing = 64 - state->leading - length;
+    }
+    length = 64 - state->leading - state->trailing;
+    state->last ^= bitReader_Get(reader, length) << state->trailing;
+    return state->last;
+}
+/* @brief Finds the decimal digits that hold every value exactly
+ *
+ * A value v fits k digits if some integer n below 2^53 gives
+ * n / 10^k == v, bit for bit.
+ * @return Digits from 0 to PACKED_MAX_DIGITS or -1 if none fit
+ * */
+static int decimalDigits(const double *values, size_t count)
+{
+    size_t index;
+    int digits = 0;
+    double scaled;
+    for (index = 0; index < count; index++)
+    {
+        for (; digits <= PACKED_MAX_DIGITS; digits++)
+        {
+            scaled = round(values[index] * powers[digits]);
+            if (fabs(scaled) < EXACT_INTEGER
+                && doubleBits((double) (int64_t) scaled / powers[digits]) == doubleBits(values[index]))
+                break;
+        }
+        if (digits > PACKED_MAX_DIGITS)
+            return -1;
+    }
+    return digits;
+}
+
+/* @brief Checks that every value is n * step for some 32 bit integer n
+ * */
+static bool fitsFixed(const double *values, size_t count, double step)
+{
+    size_t index;
+    double scaled;
+    for (index = 0; index < count; index++)
+    {
+        scaled = round(values[index] / step);
+        if (!(fabs(scaled) <= INT32_MAX)
+            || doubleBits((double) (int64_t) scaled * step) != doubleBits(values[index]))
+            return false;
+    }
+    return true;
+}
+
+/* @brief Checks that every value is exactly a float
+ * */
+static bool fitsSingle(const double *values, size_t count)
+{
+    size_t index;
+    for (index = 0; index < count; index++)
+    {
+        if (doubleBits((double) (float) values[index]) != doubleBits(values[index]))
+            return false;
+    }
+    return true;
+}
+
+/* @brief Gets the bits of a raw code of a column
+ * */
+static int column_Width(const Column *column)
+{
+    return column->kind == COLUMN_SINGLE || column->kind == COLUMN_FIXED ? 32 : 64;
+}
+
+/* @brief Turns a value into the code of a column
+ * */
+static uint64_t column_Code(const Column *column, double value)
+{
+    float single;
+    uint32_t bits;
+    switch (column->kind)
+    {
+        case COLUMN_SINGLE:
+            single = (float) value;
+            memcpy(&bits, &single, sizeof(bits));
+            return bits;
+        case COLUMN_DECIMAL:
+            return (uint64_t) (int64_t) round(value * powers[column->digits]);
+        case COLUMN_FIXED:
+            return (uint64_t) (int64_t) round(value / column->step);
+        default:
+            break;
+    }
+    return doubleBits(value);
+}
+
+/* @brief Turns a code of a column back into its value
+ * */
+static double column_Value(const Column *column, uint64_t code)
+{
+    float single;
+    uint32_t bits;
+    switch (column->kind)
+    {
+        case COLUMN_SINGLE:
+            bits = (uint32_t) code;
+            memcpy(&single, &bits, sizeof(single));
+            return single;
+        case COLUMN_DECIMAL:
+            return (double) (int64_t) code / powers[column->digits];
+        case COLUMN_FIXED:
+            return (double) (int64_t) code * column->step;
+        default:
+            break;
+    }
+    return bitsDouble(code);
+}
+
+/* @brief Reads a raw code of a column
+ * */
+static uint64_t column_Read(const Column *column, BitReader *reader)
+{
+    uint64_t code = bitReader_Get(reader, column_Width(column));
+    /* Fixed codes are signed */
+    if (column->kind == COLUMN_FIXED)
+        code = (uint64_t) (int64_t) (int32_t) (uint32_t) code;
+    return code;
+}
+
+/* @brief Writes a column of one block as codes of a kind
+ *
+ * The column starts with its kind, the digits of a decimal column & a
+ * raw flag. Encoded columns hold the first code in full, then x as the
+ * delta of delta of its codes, y as the delta of integer codes or
+ * Gorilla style for float codes. Raw columns hold every code as it is.
+ * */
+static void putCodes(BitWriter *writer, const Column *column, const double *values, size_t count, bool isX)
+{
+    XorState state;
+    uint64_t code, last, delta, lastDelta = 0;
+    size_t start, index;
+    int width = column_Width(column);
+    bitWriter_Put(writer, column->kind, 2);
+    if (column->kind == COLUMN_DECIMAL)
+        bitWriter_Put(writer, column->digits, 4);
+    start = writer->bits;
+    bitWriter_Put(writer, 0, 1);
+    last = column_Code(column, values[0]);
+    bitWriter_Put(writer, last, width);
+    state.last = last;
+    state.leading = 64;
+    state.trailing = 0;
+    for (index = 1; index < count; index++)
+    {
+        code = column_Code(column, values[index]);
+        if (isX)
+        {
+            /* Unsigned wrap around keeps the deltas lossless */
+            delta = code - last;
+            putDelta(writer, delta - lastDelta);
+            lastDelta = delta;
+        }
+        else if (column->kind == COLUMN_DECIMAL || column->kind == COLUMN_FIXED)
+        {
+            putDelta(writer, code - last);
+        }
+        else
+        {
+            putXor(writer, &state, code);
+        }
+        last = code;
+    }
+    if (writer->bits - start <= 1 + (size_t) width * count)
+        return;
+    bitWriter_Rewind(writer, start);
+    bitWriter_Put(writer, 1, 1);
+    for (index = 0; index < count; index++)
+        bitWriter_Put(writer, column_Code(column, values[index]), width);
+}
+
+/* @brief Writes the x or y values of one block in the smallest kind
+ *
+ * Every kind that holds the values exactly is tried, a float value can
+ * also be a short decimal & either may come out smaller.
+ * @param fixedStep Step of a fixed precision Curve, 0 for none
+ * */
+static void putColumn(BitWriter *writer, const double *values, size_t count, bool isX, double fixedStep)
+{
+    Column column, best;
+    size_t start = writer->bits;
+    size_t bestBits = 0;
+    int kind;
+    column.step = fixedStep;
+    best.kind = COLUMN_DOUBLE;
+    best.digits = 0;
+    best.step = fixedStep;
+    for (kind = COLUMN_DOUBLE; kind <= COLUMN_FIXED; kind++)
+    {
+        column.kind = (ColumnKind) kind;
+        column.digits = 0;
+        if ((kind == COLUMN_SINGLE && !fitsSingle(values, count))
+            || (kind == COLUMN_DECIMAL && (column.digits = decimalDigits(values, count)) < 0)
+            || (kind == COLUMN_FIXED && (fixedStep <= 0 || !fitsFixed(values, count, fixedStep))))
+            continue;
+        putCodes(writer, &column, values, count, isX);
+        if (kind == COLUMN_DOUBLE || writer->bits - start < bestBits)
+        {
+            best = column;
+            bestBits = writer->bits - start;
+        }
+        bitWriter_Rewind(writer, start);
+    }
+    putCodes(writer, &best, values, count, isX);
+}
+
+/* @brief Reads the x or y values written by putColumn
+ * */
+static void getColumn(BitReader *reader, double *values, size_t count, bool isX, double fixedStep)
+{
+    Column column;
+    XorState state;
+    uint64_t code, delta = 0;
+    size_t index;
+    column.kind = (ColumnKind) bitReader_Get(reader, 2);
+    column.digits = column.kind == COLUMN_DECIMAL ? (int) bitReader_Get(reader, 4) : 0;
+    column.step = fixedStep;
+    if (bitReader_Bit(reader))
+    {
+        for (index = 0; index < count; index++)
+            values[index] = column_Value(&column, column_Read(&column, reader));
+        return;
+    }
+    code = column_Read(&column, reader);
+    values[0] = column_Value(&column, code);
+    state.last = code;
+    state.leading = 64;
+    state.trailing = 0;
+    for (index = 1; index < count; index++)
+    {
+        if (isX)
+        {
+            delta += getDelta(reader);
+            code += delta;
+        }
+        else if (column.kind == COLUMN_DECIMAL || column.kind == COLUMN_FIXED)
+        {
+            code += getDelta(reader);
+        }
+        else
+        {
+            code = getXor(reader, &state);
+        }
+        values[index] = column_Value(&column, code);
+    }
+}
+/* endregion */
+
+/* region: PackedCurve */
+
+PackedCurve *mkPackedCurve(Curve *curve)
+{
+    PackedCurve *packed = (PackedCurve *) malloc(sizeof(PackedCurve));
+    double xs[PACKED_BLOCK_POINTS];
+    double ys[PACKED_BLOCK_POINTS];
+    BitWriter writer;
+    Point point;
+    uint64_t *words;
+    size_t block, first, count, index, windowPoints = curve_WindowPoints();
+    if (packed == NULL)
+        return NULL;
+    packed->count = curve->size;
+    packed->fixedStep = curve->precision == PRECISION_FIXED ? curve->precisionStep : 0;
+    packed->blockCount = (curve->size + PACKED_BLOCK_POINTS - 1) / PACKED_BLOCK_POINTS;
+    packed->blockOffsets = (size_t *) malloc((packed->blockCount > 0 ? packed->blockCount : 1) * sizeof(size_t));
+    packed->words = (uint64_t *) malloc(PACKED_MIN_WORDS * sizeof(uint64_t));
+    if (packed->blockOffsets == NULL || packed->words == NULL)
+    {
+        rmPackedCurve(packed);
+        return NULL;
+    }
+    writer.packed = packed;
+    writer.capacity = PACKED_MIN_WORDS;
+    writer.bits = 0;
+    writer.failed = false;
+    for (block = 0; block < packed->blockCount && !writer.failed; block++)
+    {
+        first = block * PACKED_BLOCK_POINTS;
+        count = curve->size - first < PACKED_BLOCK_POINTS ? curve->size - first : PACKED_BLOCK_POINTS;
+        for (index = 0; index < count; index++)
+        {
+            /* Walk a memory mapped Curve a window at a time */
+            if ((first + index) % windowPoints == 0 && first + index > 0)
+                curve_AdviseWindow(curve, first + index - windowPoints, first + index, false);
+            point = curve_GetAt(curve, first + index);
+            xs[index] = point.x;
+            ys[index] = point.y;
+        }
+        packed->blockOffsets[block] = writer.bits;
+        putColumn(&writer, xs, count, true, packed->fixedStep);
+        putColumn(&writer, ys, count, false, packed->fixedStep);
+    }
+    if (writer.failed)
+    {
+        rmPackedCurve(packed);
+        return NULL;
+    }
+    /* Keep one spare word so reads never run past the end, the stream
+     * may end in the last allocated word */
+    packed->wordCount = writer.bits / 64 + 2;
+    if (packed->wordCount != writer.capacity)
+    {
+        words = (uint64_t *) realloc(packed->words, packed->wordCount * sizeof(uint64_t));
+        if (words == NULL && packed->wordCount > writer.capacity)
+        {
+            rmPackedCurve(packed);
+            return NULL;
+        }
+        if (words != NULL)
+            packed->words = words;
+    }
+    if (writer.bits % 64 == 0)
+        packed->words[writer.bits / 64] = 0;
+    packed->words[writer.bits / 64 + 1] = 0;
+    packed->scaleX = 1;
+    packed->scaleY = 1;
+    packed->offsetX = 0;
+    packed->offsetY = 0;
+    packed->isAnalyzed = curve->isAnalyzed;
+    packed->lowPoint = curve->lowPoint;
+    packed->highPoint = curve->highPoint;
+    packed->length = curve->length;
+    packed->area = curve->area;
+    return packed;
+}
+
+void rmPackedCurve(PackedCurve *packed)
+{
+    if (packed == NULL)
+        return;
+    free(packed->words);
+    free(packed->blockOffsets);
+    free(packed);
+}
+
+size_t packedCurve_Decode(PackedCurve *packed, size_t block, double *xs, double *ys)
+{
+    BitReader reader;
+    size_t count, index;
+    count = packed->count - block * PACKED_BLOCK_POINTS;
+    if (count > PACKED_BLOCK_POINTS)
+        count = PACKED_BLOCK_POINTS;
+    reader.words = packed->words;
+    reader.bit = packed->blockOffsets[block];
+    getColumn(&reader, xs, count, true, packed->fixedStep);
+    getColumn(&reader, ys, count, false, packed->fixedStep);
+    if (packed->scaleX != 1 || packed->offsetX != 0 || packed->scaleY != 1 || packed->offsetY != 0)
+    {
+        for (index = 0; index < count; index++)
+        {
+            xs[index] = xs[index] * packed->scaleX + packed->offsetX;
+            ys[index] = ys[index] * packed->scaleY + packed->offsetY;
+        }
+    }
+    return count;
+}
+
+bool packedCurve_Unpack(PackedCurve *packed, Curve *curve)
+{
+    size_t block;
+    curve_Clear(curve);
+    if (!curve_Reserve(curve, packed->count))
+        return false;
+    for (block = 0; block < packed->blockCount; block++)
+        curve->size += packedCurve_Decode(packed, block, (double *) curve->xs + curve->size,
+                                          (double *) curve->ys + curve->size);
+    curve->isAnalyzed = packed->isAnalyzed;
+    curve->lowPoint = packed->lowPoint;
+    curve->highPoint = packed->highPoint;
+    curve->length = packed->length;
+    curve->area = packed->area;
+    return true;
+}
+
+void packedCurve_Analyze(PackedCurve *packed)
+{
+    /* Slot 0 holds the last point of the block before, for the segment
+     * joining the blocks */
+    double xs[PACKED_BLOCK_POINTS + 1];
+    double ys[PACKED_BLOCK_POINTS + 1];
+    CurveStats stats;
+    size_t block, count, first;
+    packed->length = 0;
+    packed->area = 0;
+    for (block = 0; block < packed->blockCount; block++)
+    {
+        count = packedCurve_Decode(packed, block, xs + 1, ys + 1);
+        first = block > 0 ? 0 : 1;
+        calcCurveStats(xs + first, ys + first, count + 1 - first, &stats);
+        packed->length += stats.length;
+        packed->area += stats.area;
+        /* Strictly lower & higher keep the first extreme */
+        if (block == 0 || ys[first + stats.lowIndex] < packed->lowPoint.y)
+        {
+            packed->lowPoint.x = xs[first + stats.lowIndex];
+            packed->lowPoint.y = ys[first + stats.lowIndex];
+        }
+        if (block == 0 || ys[first + stats.highIndex] > packed->highPoint.y)
+        {
+            packed->highPoint.x = xs[first + stats.highIndex];
+            packed->highPoint.y = ys[first + stats.highIndex];
+        }
+        xs[0] = xs[count];
+        ys[0] = ys[count];
+    }
+    if (packed->count == 0)
+    {
+        packed->lowPoint.x = 0;
+        packed->lowPoint.y = 0;
+        packed->highPoint = packed->lowPoint;
+    }
+    packed->isAnalyzed = true;
+}
+
+void packedCurve_Transform(PackedCurve *packed, double scaleX, double scaleY, double shiftX, double shiftY)
+{
+    packed->scaleX *= scaleX;
+    packed->offsetX = packed->offsetX * scaleX + shiftX;
+    packed->scaleY *= scaleY;
+    packed->offsetY = packed->offsetY * scaleY + shiftY;
+    if (scaleX == 1 && scaleY == 1 && shiftY == 0)
+    {
+        packed->lowPoint.x += shiftX;
+        packed->highPoint.x += shiftX;
+    }
+    else
+    {
+        packed->isAnalyzed = false;
+    }
+}
+
+size_t packedCurve_Bytes(PackedCurve *packed)
+{
+    return sizeof(PackedCurve) + packed->wordCount * sizeof(uint64_t) + packed->blockCount * sizeof(size_t);
+}
+/* endregion */
@@ -0,0 +1,105 @@
+#include "point.h"
+#include "curve.h"
+#ifndef PACKED_H
+    #define PACKED_H
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Points per independently decodable block */
+#define PACKED_BLOCK_POINTS 1024
+
+/* @brief Compressed, read only copy of the points of a Curve
+ *
+ * Points are cut into blocks of PACKED_BLOCK_POINTS that each decode
+ * without the others, a block holds its x values then its y values. X
+ * is stored as a delta of delta, costing one bit for evenly spaced x,
+ * & y Gorilla style, as the XOR with the previous y trimmed to its
+ * meaningful bits. Values that are short decimals, as most text files
+ * hold, are stored as the integers n of n / 10^k instead, the values of
+ * float & fixed precision Curves as 32 bit codes. Every encoding is
+ * lossless, a block never takes more than its raw doubles, or its raw
+ * 32 bit codes for a float or fixed precision Curve.
+ *
+ * Like a Curve, shifts & scales are recorded & applied while decoding.
+ * */
+typedef struct
+{
+    /* Bit stream of every block, most significant bit first */
+    uint64_t *words;
+    size_t wordCount;
+    /* Bit offset of each block in words */
+    size_t *blockOffsets;
+    size_t blockCount;
+    /* Number of points */
+    size_t count;
+    /* Step of a fixed precision Curve, 0 for other precisions */
+    double fixedStep;
+    /* Pending transform of the stored coordinates */
+    double scaleX;
+    double scaleY;
+    double offsetX;
+    double offsetY;
+    /* True if length, area, lowPoint & highPoint describe the points */
+    bool isAnalyzed;
+    Point lowPoint;
+    Point highPoint;
+    double length;
+    double area;
+}PackedCurve;
+
+/* @brief Compresses the points of a Curve
+ *
+ * The pending transform of the Curve is applied, its statistics are
+ * copied if they are up to date.
+ * @param *curve Curve to compress, left untouched
+ * @return Memory of new PackedCurve or NULL
+ * */
+PackedCurve *mkPackedCurve(Curve *curve);
+
+/* @brief Frees memory allocated to a PackedCurve
+ * @param *packed Target PackedCurve, may be NULL
+ * */
+void rmPackedCurve(PackedCurve *packed);
+
+/* @brief Decodes one block of points
+ * @param *packed Target PackedCurve
+ * @param block Index of the block
+ * @param *xs At least PACKED_BLOCK_POINTS x values
+ * @param *ys At least PACKED_BLOCK_POINTS y values
+ * @return Number of points decoded
+ * */
+size_t packedCurve_Decode(PackedCurve *packed, size_t block, double *xs, double *ys);
+
+/* @brief Decodes every point into a Curve
+ * @param *packed Target PackedCurve
+ * @param *curve Curve to fill, cleared first
+ * @return Returns false if memory could not be allocated
+ * */
+bool packedCurve_Unpack(PackedCurve *packed, Curve *curve);
+
+/* @brief Recalculates length, area, lowPoint & highPoint
+ *
+ * Blocks are decoded one at a time, the points are never unpacked.
+ * @param *packed Target PackedCurve
+ * */
+void packedCurve_Analyze(PackedCurve *packed);
+
+/* @brief Scales then shifts the points of a PackedCurve, O(1)
+ *
+ * Shifts along x keep the statistics, anything else leaves them for
+ * packedCurve_Analyze.
+ * @param *packed Target PackedCurve
+ * @param scaleX Value to multiply X by
+ * @param scaleY Value to multiply Y by
+ * @param shiftX Value to shift X
+ * @param shiftY Value to shift Y
+ * */
+void packedCurve_Transform(PackedCurve *packed, double scaleX, double scaleY, double shiftX, double shiftY);
+
+/* @brief Gets the memory held by a PackedCurve
+ * @param *packed Target PackedCurve
+ * @return Bytes allocated
+ * */
+size_t packedCurve_Bytes(PackedCurve *packed);
+#endif
@@ -0,0 +1,115 @@
+#define _POSIX_C_SOURCE 200809L
+#include "perf.h"
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+static const char *sectionNames[PERF_SECTION_COUNT] =
+{
+    "Load", "Analyze", "Shift/scale", "Commit", "Save", "Clear"
+};
+
+static const char *allocNames[PERF_ALLOC_COUNT] =
+{
+    "Chunks", "Points", "Arrays"
+};
+
+/* Hot path totals, guarded by sectionLock */
+static PerfCounter sections[PERF_SECTION_COUNT];
+static pthread_mutex_t sectionLock = PTHREAD_MUTEX_INITIALIZER;
+/* Allocation totals, updated atomically since they are hit per point */
+static size_t allocCounts[PERF_ALLOC_COUNT];
+static size_t allocBytes[PERF_ALLOC_COUNT];
+
+double perf_Start()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void perf_Stop(PerfSection section, double startTime, size_t bytes, size_t points)
+{
+    double seconds = perf_Start() - startTime;
+    pthread_mutex_lock(&sectionLock);
+    sections[section].calls++;
+    sections[section].seconds += seconds;
+    sections[section].bytes += bytes;
+    sections[section].points += points;
+    pthread_mutex_unlock(&sectionLock);
+}
+
+void perf_CountAlloc(PerfAlloc kind, size_t bytes)
+{
+    __atomic_fetch_add(&allocCounts[kind], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocBytes[kind], bytes, __ATOMIC_RELAXED);
+}
+
+void perf_Get(PerfSection section, PerfCounter *counter)
+{
+    pthread_mutex_lock(&sectionLock);
+    *counter = sections[section];
+    pthread_mutex_unlock(&sectionLock);
+}
+
+size_t perf_GetAlloc(PerfAlloc kind, size_t *bytes)
+{
+    if (bytes != NULL)
+        *bytes = __atomic_load_n(&allocBytes[kind], __ATOMIC_RELAXED);
+    return __atomic_load_n(&allocCounts[kind], __ATOMIC_RELAXED);
+}
+
+const char *perf_SectionName(PerfSection section)
+{
+    return sectionNames[section];
+}
+
+const char *perf_AllocName(PerfAlloc kind)
+{
+    return allocNames[kind];
+}
+
+void perf_Reset()
+{
+    int loopVar;
+    pthread_mutex_lock(&sectionLock);
+    for (loopVar = 0; loopVar < PERF_SECTION_COUNT; loopVar++)
+    {
+        sections[loopVar].calls = 0;
+        sections[loopVar].seconds = 0;
+        sections[loopVar].bytes = 0;
+        sections[loopVar].points = 0;
+    }
+    pthread_mutex_unlock(&sectionLock);
+    for (loopVar = 0; loopVar < PERF_ALLOC_COUNT; loopVar++)
+    {
+        __atomic_store_n(&allocCounts[loopVar], 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&allocBytes[loopVar], 0, __ATOMIC_RELAXED);
+    }
+}
+
+void perf_Print(FILE *output)
+{
+    PerfCounter counter;
+    size_t count, bytes;
+    int loopVar;
+    fprintf(output, "%-12s %8s %12s %12s %14s\n", "Path", "Calls", "Time (ms)", "MB", "Points");
+    for (loopVar = 0; loopVar < PERF_SECTION_COUNT; loopVar++)
+    {
+        perf_Get(loopVar, &counter);
+        fprintf(output, "%-12s %8zu %12.3f %12.3f %14zu\n", sectionNames[loopVar], counter.calls,
+                counter.seconds * 1e3, counter.bytes / (1024.0 * 1024.0), counter.points);
+    }
+    fprintf(output, "%-12s %8s %12s %12s\n", "Allocation", "", "Count", "MB");
+    for (loopVar = 0; loopVar < PERF_ALLOC_COUNT; loopVar++)
+    {
+        count = perf_GetAlloc(loopVar, &bytes);
+        fprintf(output, "%-12s %8s %12zu %12.3f\n", allocNames[loopVar], "", count, bytes / (1024.0 * 1024.0));
+    }
+}
+
+bool perf_IsDumpRequested()
+{
+    const char *value = getenv("NCURVECALC_PERF");
+    return value != NULL && *value != '\0';
+}
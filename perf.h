@@ -0,0 +1,106 @@
+#ifndef PERF_H
+    #define PERF_H
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/* @brief Timed hot paths
+ * */
+typedef enum
+{
+    /* curve_LoadFile & streamStats_Read */
+    PERF_LOAD,
+    /* initCurve */
+    PERF_INIT_CURVE,
+    /* mvCurve & curve_Transform */
+    PERF_TRANSFORM,
+    /* curve_Commit */
+    PERF_COMMIT,
+    /* curve_SaveBinary & curve_SaveText */
+    PERF_SAVE,
+    /* curve_Clear */
+    PERF_CLEAR,
+    PERF_SECTION_COUNT
+}PerfSection;
+
+/* @brief Counted allocations
+ * */
+typedef enum
+{
+    /* List Chunks, from malloc or a List's pool */
+    PERF_CHUNK,
+    /* Points, from mkPoint or a Pool */
+    PERF_POINT,
+    /* Coordinate arrays of a Curve */
+    PERF_ARRAY,
+    PERF_ALLOC_COUNT
+}PerfAlloc;
+
+/* @brief Totals recorded for a hot path
+ * */
+typedef struct
+{
+    /* Number of times the path ran */
+    size_t calls;
+    /* Wall time in seconds */
+    double seconds;
+    /* Bytes read or written */
+    size_t bytes;
+    /* Points processed */
+    size_t points;
+}PerfCounter;
+
+/* @brief Gets a time stamp to pass to perf_Stop
+ * @return Monotonic seconds
+ * */
+double perf_Start();
+
+/* @brief Records a run of a hot path, safe to call from any thread
+ * @param section Hot path that ran
+ * @param startTime Value of perf_Start when the path began
+ * @param bytes Bytes read or written
+ * @param points Points processed
+ * */
+void perf_Stop(PerfSection section, double startTime, size_t bytes, size_t points);
+
+/* @brief Counts an allocation, safe to call from any thread
+ * @param kind Kind of allocation
+ * @param bytes Size of the allocation
+ * */
+void perf_CountAlloc(PerfAlloc kind, size_t bytes);
+
+/* @brief Gets the totals of a hot path
+ * @param section Target hot path
+ * @param *counter Filled with the totals
+ * */
+void perf_Get(PerfSection section, PerfCounter *counter);
+
+/* @brief Gets the allocation count of a kind
+ * @param kind Target kind of allocation
+ * @param *bytes Filled with the bytes allocated, may be NULL
+ * @return Number of allocations
+ * */
+size_t perf_GetAlloc(PerfAlloc kind, size_t *bytes);
+
+/* @brief Gets the display name of a hot path
+ * */
+const char *perf_SectionName(PerfSection section);
+
+/* @brief Gets the display name of a kind of allocation
+ * */
+const char *perf_AllocName(PerfAlloc kind);
+
+/* @brief Sets every counter back to zero
+ * */
+void perf_Reset();
+
+/* @brief Writes every counter as a table
+ * @param *output Target stream
+ * */
+void perf_Print(FILE *output);
+
+/* @brief Checks if counters should be written out when the program exits
+ * @return Returns true if NCURVECALC_PERF is set & not empty
+ * */
+bool perf_IsDumpRequested();
+#endif
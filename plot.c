@@ -0,0 +1,185 @@
+#include "plot.h"
+#include "range.h"
+#include <stdlib.h>
+#include <math.h>
+
+/* Points per level 0 entry, runs shorter than this are scanned directly */
+#define PLOT_BLOCK 64
+
+/* @brief Gets the number of points one entry of a level covers
+ * */
+static size_t blockSize(int level)
+{
+    return (size_t) PLOT_BLOCK << level;
+}
+
+/* @brief Gets the y of a Curve where it crosses a vertical line
+ * @return Interpolated transformed y, NaN if x is outside the curve
+ * */
+static double crossingY(Curve *curve, double x, size_t next)
+{
+    Point point1, point2;
+    if (next >= curve->size)
+        return NAN;
+    point2 = curve_GetAt(curve, next);
+    if (point2.x == x)
+        return point2.y;
+    if (next == 0)
+        return NAN;
+    point1 = curve_GetAt(curve, next - 1);
+    return point1.y + (point2.y - point1.y) * (x - point1.x) / (point2.x - point1.x);
+}
+
+PlotIndex *mkPlotIndex(Curve *curve)
+{
+    PlotIndex *index = (PlotIndex *) malloc(sizeof(PlotIndex));
+    size_t entries, total, loopVar, child, size;
+    double *lows, *highs, *below, *belowHighs;
+    int level;
+    if (index == NULL)
+        return NULL;
+    index->count = curve->size;
+    /* Level sizes halve until one entry covers every point */
+    entries = (curve->size + PLOT_BLOCK - 1) / PLOT_BLOCK;
+    total = 0;
+    index->levelCount = 0;
+    do
+    {
+        index->levelStarts[index->levelCount++] = total;
+        total += entries;
+        entries = (entries + 1) / 2;
+    }
+    while (total > index->levelStarts[index->levelCount - 1] + 1 && index->levelCount < 64);
+    index->lows = (double *) malloc((total > 0 ? total : 1) * sizeof(double));
+    index->highs = (double *) malloc((total > 0 ? total : 1) * sizeof(double));
+    if (index->lows == NULL || index->highs == NULL)
+    {
+        rmPlotIndex(index);
+        return NULL;
+    }
+    /* Level 0 from the points */
+    entries = (curve->size + PLOT_BLOCK - 1) / PLOT_BLOCK;
+    for (loopVar = 0; loopVar < entries; loopVar++)
+    {
+        index->lows[loopVar] = INFINITY;
+        index->highs[loopVar] = -INFINITY;
+    }
+    for (loopVar = 0; loopVar < curve->size; loopVar++)
+    {
+        size = loopVar / PLOT_BLOCK;
+        index->lows[size] = fmin(index->lows[size], curve_StoredY(curve, loopVar));
+        index->highs[size] = fmax(index->highs[size], curve_StoredY(curve, loopVar));
+    }
+    /* Every other level from the level below */
+    for (level = 1; level < index->levelCount; level++)
+    {
+        below = index->lows + index->levelStarts[level - 1];
+        belowHighs = index->highs + index->levelStarts[level - 1];
+        lows = index->lows + index->levelStarts[level];
+        highs = index->highs + index->levelStarts[level];
+        size = index->levelStarts[level] - index->levelStarts[level - 1];
+        entries = (size + 1) / 2;
+        for (loopVar = 0; loopVar < entries; loopVar++)
+        {
+            child = 2 * loopVar;
+            lows[loopVar] = below[child];
+            highs[loopVar] = belowHighs[child];
+            if (child + 1 < size)
+            {
+                lows[loopVar] = fmin(lows[loopVar], below[child + 1]);
+                highs[loopVar] = fmax(highs[loopVar], belowHighs[child + 1]);
+            }
+        }
+    }
+    return index;
+}
+
+void rmPlotIndex(PlotIndex *index)
+{
+    if (index == NULL)
+        return;
+    free(index->lows);
+    free(index->highs);
+    free(index);
+}
+
+void plotIndex_Range(PlotIndex *index, Curve *curve, size_t first, size_t end, double *low, double *high)
+{
+    double storedLow = INFINITY;
+    double storedHigh = -INFINITY;
+    double swap;
+    size_t entry;
+    int level;
+    /* Points before the first whole block */
+    while (first < end && (first % PLOT_BLOCK != 0 || end - first < PLOT_BLOCK))
+    {
+        storedLow = fmin(storedLow, curve_StoredY(curve, first));
+        storedHigh = fmax(storedHigh, curve_StoredY(curve, first));
+        first++;
+    }
+    /* Largest aligned blocks that fit */
+    while (first + PLOT_BLOCK <= end)
+    {
+        level = 0;
+        while (level + 1 < index->levelCount && first % blockSize(level + 1) == 0
+               && first + blockSize(level + 1) <= end)
+            level++;
+        entry = index->levelStarts[level] + first / blockSize(level);
+        storedLow = fmin(storedLow, index->lows[entry]);
+        storedHigh = fmax(storedHigh, index->highs[entry]);
+        first += blockSize(level);
+    }
+    /* Points after the last whole block */
+    for (; first < end; first++)
+    {
+        storedLow = fmin(storedLow, curve_StoredY(curve, first));
+        storedHigh = fmax(storedHigh, curve_StoredY(curve, first));
+    }
+    *low = storedLow * curve->scaleY + curve->offsetY;
+    *high = storedHigh * curve->scaleY + curve->offsetY;
+    if (curve->scaleY < 0)
+    {
+        swap = *low;
+        *low = *high;
+        *high = swap;
+    }
+}
+
+void curve_PlotColumns(PlotIndex *index, Curve *curve, double fromX, double toX, size_t columns,
+                       double *lows, double *highs)
+{
+    size_t column, leftIndex, rightIndex, first, end;
+    double leftY, rightY, rightX, low, high;
+    bool isAscending;
+    if (curve->size == 0)
+    {
+        for (column = 0; column < columns; column++)
+        {
+            lows[column] = NAN;
+            highs[column] = NAN;
+        }
+        return;
+    }
+    isAscending = curve_GetAt(curve, curve->size - 1).x >= curve_GetAt(curve, 0).x;
+    leftIndex = curve_FindX(curve, fromX);
+    leftY = crossingY(curve, fromX, leftIndex);
+    for (column = 0; column < columns; column++)
+    {
+        rightX = fromX + (toX - fromX) * (column + 1) / columns;
+        rightIndex = curve_FindX(curve, rightX);
+        rightY = crossingY(curve, rightX, rightIndex);
+        /* fmin & fmax skip NaN edges outside the curve */
+        lows[column] = fmin(leftY, rightY);
+        highs[column] = fmax(leftY, rightY);
+        first = isAscending ? leftIndex : rightIndex;
+        end = isAscending ? rightIndex : leftIndex;
+        if (first < end)
+        {
+            plotIndex_Range(index, curve, first, end, &low, &high);
+            lows[column] = fmin(lows[column], low);
+            highs[column] = fmax(highs[column], high);
+        }
+        leftIndex = rightIndex;
+        leftY = rightY;
+    }
+}
@@ -0,0 +1,67 @@
+#include "curve.h"
+#ifndef PLOT_H
+    #define PLOT_H
+#include <stddef.h>
+#include <stdbool.h>
+
+/* @brief Pyramid of lowest & highest stored y over blocks of points
+ *
+ * Level 0 holds one entry per PLOT_BLOCK points, each level above joins
+ * two entries of the level below. Any run of points is covered by at
+ * most two partial blocks & O(log n) whole ones, so a plot column costs
+ * the same whatever the number of points it spans.
+ * */
+typedef struct
+{
+    /* Entries of every level, level 0 first */
+    double *lows;
+    double *highs;
+    /* Offset of each level in lows & highs */
+    size_t levelStarts[64];
+    int levelCount;
+    /* Number of points covered */
+    size_t count;
+}PlotIndex;
+
+/* @brief Builds a PlotIndex over the stored y values of a Curve
+ *
+ * The index describes the stored points, it stays valid through
+ * curve_Transform but not curve_Commit or any change of the points.
+ * @param *curve Target Curve
+ * @return Memory of new PlotIndex or NULL
+ * */
+PlotIndex *mkPlotIndex(Curve *curve);
+
+/* @brief Frees memory allocated to a PlotIndex
+ * @param *index Target PlotIndex, may be NULL
+ * */
+void rmPlotIndex(PlotIndex *index);
+
+/* @brief Finds the lowest & highest y of a run of points
+ * @param *index PlotIndex of the Curve
+ * @param *curve Target Curve
+ * @param first Index of the first point
+ * @param end Index after the last point, more than first
+ * @param *low Lowest transformed y
+ * @param *high Highest transformed y
+ * */
+void plotIndex_Range(PlotIndex *index, Curve *curve, size_t first, size_t end, double *low, double *high);
+
+/* @brief Downsamples a Curve to one y span per column of a plot
+ *
+ * Column c covers x from fromX + c * width to fromX + (c + 1) * width
+ * with width = (toX - fromX) / columns. Its span holds every point in
+ * the column & the curve where it crosses the column edges, so peaks
+ * are kept & neighbouring spans join up. Columns outside the curve get
+ * NaN spans.
+ * @param *index PlotIndex of the Curve
+ * @param *curve Target Curve
+ * @param fromX Left edge of the plot
+ * @param toX Right edge of the plot, more than fromX
+ * @param columns Number of columns
+ * @param *lows Lowest y of each column
+ * @param *highs Highest y of each column
+ * */
+void curve_PlotColumns(PlotIndex *index, Curve *curve, double fromX, double toX, size_t columns,
+                       double *lows, double *highs);
+#endif
@@ -1,4 +1,5 @@
 #include "point.h"
+#include "perf.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -6,11 +7,24 @@
 Point *mkPoint(double x, double y)
 {
 	Point *point = (Point *) malloc(sizeof(Point));
+	perf_CountAlloc(PERF_POINT, sizeof(Point));
 	point->x = x;
 	point->y = y;
 	return point;
 }
 
+Point *mkPointPooled(Pool *pool, double x, double y)
+{
+	Point *point = (Point *) pool_Alloc(pool, sizeof(Point));
+	perf_CountAlloc(PERF_POINT, sizeof(Point));
+	if (point != NULL)
+	{
+		point->x = x;
+		point->y = y;
+	}
+	return point;
+}
+
 void rmPoint(Point *point)
 {
 	if (point != NULL)
@@ -28,13 +42,15 @@ void shiftPoint(Point *point, double x, double y)
 double calcPointLength(Point *point1, Point *point2)
 {
     double length;
-    length = sqrt(pow(point1->x - point2->x, 2) + pow(point1->y - point2->y, 2));
+    double dx = point1->x - point2->x;
+    double dy = point1->y - point2->y;
+    length = sqrt(dx * dx + dy * dy);
     return length;
 }
 
 double calcPointArea(Point *point1, Point *point2)
 {
     double area;
-    area = abs(point2->x - point1->x) * ((abs(point1->y) + abs(point2->y))/2);
+    area = fabs(point2->x - point1->x) * ((fabs(point1->y) + fabs(point2->y))/2);
     return area;
 }
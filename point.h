@@ -1,5 +1,6 @@
 #ifndef POINT_H
     #define POINT_H
+#include "clist.h"
 typedef struct
 {
 	double x;
@@ -13,6 +14,14 @@ typedef struct
  * */
 Point *mkPoint(double x, double y);
 
+/* @brief Allocates a Point structure out of a Pool's slabs
+ * @param *pool Pool to allocate from, the Point is freed by rmPool
+ * @param x Value of x
+ * @param y Value of y
+ * @return Memory of new Point
+ * */
+Point *mkPointPooled(Pool *pool, double x, double y);
+
 /* @brief Frees memory allocated to a Point structure
  * @param *point Target Point
  * */
@@ -0,0 +1,286 @@
+#include "point.h"
+#include "curve.h"
+#include "range.h"
+#include <stdlib.h>
+#include <math.h>
+
+/* @brief Measures segment i, from point i to point i + 1
+ * */
+static void measureSegment(const Curve *curve, size_t segment, double *length, double *area)
+{
+    Point point1, point2;
+    point1.x = curve_StoredX(curve, segment);
+    point1.y = curve_StoredY(curve, segment);
+    point2.x = curve_StoredX(curve, segment + 1);
+    point2.y = curve_StoredY(curve, segment + 1);
+    *length = calcPointLength(&point1, &point2);
+    *area = calcPointArea(&point1, &point2);
+}
+
+/* @brief Sums slots 1 to slot of a Fenwick tree
+ * */
+static double fenwick_Prefix(const double *tree, size_t slot)
+{
+    double sum = 0;
+    for (; slot > 0; slot -= slot & -slot)
+        sum += tree[slot];
+    return sum;
+}
+
+/* @brief Makes room for a number of segments
+ * @return Returns false if memory could not be allocated
+ * */
+static bool rangeIndex_Reserve(RangeIndex *index, size_t capacity)
+{
+    double *lengths, *areas;
+    if (capacity <= index->capacity)
+        return true;
+    lengths = (double *) realloc(index->lengths, (capacity + 1) * sizeof(double));
+    if (lengths == NULL)
+        return false;
+    index->lengths = lengths;
+    areas = (double *) realloc(index->areas, (capacity + 1) * sizeof(double));
+    if (areas == NULL)
+        return false;
+    index->areas = areas;
+    index->capacity = capacity;
+    return true;
+}
+
+RangeIndex *mkRangeIndex(const Curve *curve)
+{
+    size_t count = curve->size;
+    double y;
+    RangeIndex *index = (RangeIndex *) malloc(sizeof(RangeIndex));
+    size_t segments = count > 1 ? count - 1 : 0;
+    size_t slot, parent;
+    if (index == NULL)
+        return NULL;
+    index->lengths = NULL;
+    index->areas = NULL;
+    index->count = segments;
+    index->capacity = 0;
+    index->lowY = count > 0 ? curve_StoredY(curve, 0) : 0;
+    index->highY = index->lowY;
+    if (!rangeIndex_Reserve(index, segments > 0 ? segments : 1))
+    {
+        rmRangeIndex(index);
+        return NULL;
+    }
+    for (slot = 0; slot < count; slot++)
+    {
+        y = curve_StoredY(curve, slot);
+        if (y < index->lowY)
+            index->lowY = y;
+        if (y > index->highY)
+            index->highY = y;
+    }
+    /* Linear build, every slot passes its total up to its parent */
+    for (slot = 1; slot <= segments; slot++)
+        measureSegment(curve, slot - 1, &index->lengths[slot], &index->areas[slot]);
+    for (slot = 1; slot <= segments; slot++)
+    {
+        parent = slot + (slot & -slot);
+        if (parent <= segments)
+        {
+            index->lengths[parent] += index->lengths[slot];
+            index->areas[parent] += index->areas[slot];
+        }
+    }
+    return index;
+}
+
+void rmRangeIndex(RangeIndex *index)
+{
+    if (index != NULL)
+    {
+        free(index->lengths);
+        free(index->areas);
+        free(index);
+    }
+}
+
+bool rangeIndex_Append(RangeIndex *index, const Curve *curve)
+{
+    size_t slot = curve->size - 1;
+    size_t stop = slot - (slot & -slot);
+    double length, area;
+    double y = curve_StoredY(curve, slot);
+    if (curve->size == 1)
+    {
+        index->lowY = y;
+        index->highY = y;
+        return true;
+    }
+    if (slot > index->capacity && !rangeIndex_Reserve(index, slot > 2 * index->capacity ? slot : 2 * index->capacity))
+        return false;
+    measureSegment(curve, slot - 1, &length, &area);
+    /* The new slot covers slots stop + 1 to slot */
+    index->lengths[slot] = length + fenwick_Prefix(index->lengths, slot - 1) - fenwick_Prefix(index->lengths, stop);
+    index->areas[slot] = area + fenwick_Prefix(index->areas, slot - 1) - fenwick_Prefix(index->areas, stop);
+    index->count = slot;
+    if (y < index->lowY)
+        index->lowY = y;
+    if (y > index->highY)
+        index->highY = y;
+    return true;
+}
+
+void rangeIndex_Sum(RangeIndex *index, size_t first, size_t last, double *length, double *area)
+{
+    *length = fenwick_Prefix(index->lengths, last) - fenwick_Prefix(index->lengths, first);
+    *area = fenwick_Prefix(index->areas, last) - fenwick_Prefix(index->areas, first);
+}
+
+/* @brief Finds the first x past a bound, in the direction of the curve
+ *
+ * Compares the transformed x values, exactly as curve_GetAt gives them.
+ * @param isInclusive True to stop at x equal to bound
+ * */
+static size_t searchX(Curve *curve, double bound, bool isAscending, bool isInclusive)
+{
+    size_t low = 0;
+    size_t high = curve->size;
+    size_t middle;
+    double x;
+    bool isPast;
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        x = curve_StoredX(curve, middle) * curve->scaleX + curve->offsetX;
+        if (isAscending)
+            isPast = isInclusive ? x >= bound : x > bound;
+        else
+            isPast = isInclusive ? x <= bound : x < bound;
+        if (isPast)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return low;
+}
+
+/* @brief Adds the part of a segment between two x values, interpolating
+ * the cut ends
+ * */
+static void addClipped(Curve *curve, size_t segment, double fromX, double toX, double *length, double *area)
+{
+    Point point1 = curve_GetAt(curve, segment);
+    Point point2 = curve_GetAt(curve, segment + 1);
+    Point cut1, cut2;
+    double lowX = fmax(fmin(point1.x, point2.x), fromX);
+    double highX = fmin(fmax(point1.x, point2.x), toX);
+    if (!(lowX < highX))
+        return;
+    cut1.x = lowX;
+    cut1.y = point1.y + (point2.y - point1.y) * (lowX - point1.x) / (point2.x - point1.x);
+    cut2.x = highX;
+    cut2.y = point1.y + (point2.y - point1.y) * (highX - point1.x) / (point2.x - point1.x);
+    *length += calcPointLength(&cut1, &cut2);
+    *area += calcPointArea(&cut1, &cut2);
+}
+
+/* @brief Checks if sums over the stored points can be carried through the
+ * pending transform
+ *
+ * Lengths need both axes scaled alike. Areas need no y shift, or stored &
+ * shifted y values that each stay on one side of 0.
+ * */
+static bool isTransformable(Curve *curve, RangeIndex *index)
+{
+    double low = index->lowY * curve->scaleY + curve->offsetY;
+    double high = index->highY * curve->scaleY + curve->offsetY;
+    if (curve->scaleX == 0 || fabs(curve->scaleX) != fabs(curve->scaleY))
+        return false;
+    if (curve->offsetY == 0)
+        return true;
+    return (index->lowY >= 0 || index->highY <= 0)
+        && ((low >= 0 && high >= 0) || (low <= 0 && high <= 0));
+}
+
+bool curve_RangeStats(Curve *curve, double fromX, double toX, double *length, double *area)
+{
+    RangeIndex *index;
+    double swap, sumLength, sumArea, span;
+    double sign, storedSign;
+    size_t first, end;
+    bool isAscending;
+    *length = 0;
+    *area = 0;
+    if (fromX > toX)
+    {
+        swap = fromX;
+        fromX = toX;
+        toX = swap;
+    }
+    if (curve->size < 2 || !(fromX < toX))
+        return true;
+    if (curve->rangeIndex != NULL && !isTransformable(curve, curve->rangeIndex) && !curve_Commit(curve))
+        return false;
+    if (curve->rangeIndex == NULL)
+    {
+        curve->rangeIndex = mkRangeIndex(curve);
+        if (curve->rangeIndex == NULL)
+            return false;
+        if (!isTransformable(curve, curve->rangeIndex))
+        {
+            if (!curve_Commit(curve))
+                return false;
+            curve->rangeIndex = mkRangeIndex(curve);
+            if (curve->rangeIndex == NULL)
+                return false;
+        }
+    }
+    index = curve->rangeIndex;
+    /* Points inside the range are first to end - 1 */
+    isAscending = curve_GetAt(curve, curve->size - 1).x >= curve_GetAt(curve, 0).x;
+    if (isAscending)
+    {
+        first = searchX(curve, fromX, true, true);
+        end = searchX(curve, toX, true, false);
+    }
+    else
+    {
+        first = searchX(curve, toX, false, true);
+        end = searchX(curve, fromX, false, false);
+    }
+    if (end >= first + 2)
+    {
+        rangeIndex_Sum(index, first, end - 1, &sumLength, &sumArea);
+        sumLength *= fabs(curve->scaleX);
+        if (curve->offsetY == 0)
+        {
+            sumArea *= fabs(curve->scaleX * curve->scaleY);
+        }
+        else
+        {
+            /* |scaleY * y + offsetY| is sign * (scaleY * y + offsetY) with
+             * one sign for the whole curve, see isTransformable */
+            span = fabs(curve_StoredX(curve, end - 1) - curve_StoredX(curve, first));
+            sign = index->lowY * curve->scaleY + curve->offsetY >= 0
+                && index->highY * curve->scaleY + curve->offsetY >= 0 ? 1 : -1;
+            storedSign = index->lowY >= 0 ? 1 : -1;
+            if (curve->scaleY < 0)
+                storedSign = -storedSign;
+            sumArea = fabs(curve->scaleX) * (sign * storedSign * fabs(curve->scaleY) * sumArea
+                + sign * curve->offsetY * span);
+        }
+        *length += sumLength;
+        *area += sumArea;
+    }
+    /* Segments cut by the ends of the range */
+    if (first > 0 && first < curve->size)
+        addClipped(curve, first - 1, fromX, toX, length, area);
+    if (end > first && end < curve->size)
+        addClipped(curve, end - 1, fromX, toX, length, area);
+    return true;
+}
+
+size_t curve_FindX(Curve *curve, double x)
+{
+    bool isAscending;
+    if (curve->size == 0)
+        return 0;
+    isAscending = curve_GetAt(curve, curve->size - 1).x >= curve_GetAt(curve, 0).x;
+    return searchX(curve, x, isAscending, true);
+}
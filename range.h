@@ -0,0 +1,79 @@
+#include "curve.h"
+#ifndef RANGE_H
+    #define RANGE_H
+#include <stddef.h>
+#include <stdbool.h>
+
+/* @brief Prefix sums of segment length & area over a Curve's stored points
+ *
+ * Two Fenwick trees over the segments, segment i joins point i & i + 1
+ * and is measured as calcPointLength & calcPointArea. Built over the
+ * stored coordinates, a pending transform of the Curve is applied to the
+ * sums when they are read.
+ * */
+typedef struct RangeIndex
+{
+    /* 1-based Fenwick trees, one slot per segment */
+    double *lengths;
+    double *areas;
+    /* Number of segments held */
+    size_t count;
+    /* Number of segments allocated */
+    size_t capacity;
+    /* Smallest & largest stored y */
+    double lowY;
+    double highY;
+}RangeIndex;
+
+/* @brief Builds a RangeIndex over the stored points of a Curve in O(n)
+ * @param *curve Target Curve
+ * @return Memory of new RangeIndex or NULL
+ * */
+RangeIndex *mkRangeIndex(const Curve *curve);
+
+/* @brief Frees memory allocated to a RangeIndex
+ * @param *index Target RangeIndex, may be NULL
+ * */
+void rmRangeIndex(RangeIndex *index);
+
+/* @brief Adds the segment ending at the last point in O(log n)
+ * @param *index Target RangeIndex, holding size - 2 segments
+ * @param *curve Curve the index is built over, including the new point
+ * @return Returns false if memory could not be allocated
+ * */
+bool rangeIndex_Append(RangeIndex *index, const Curve *curve);
+
+/* @brief Sums segment lengths & areas of segments first to last - 1
+ * @param *index Target RangeIndex
+ * @param first First segment
+ * @param last Segment after the last one
+ * @param *length Sum of lengths
+ * @param *area Sum of areas
+ * */
+void rangeIndex_Sum(RangeIndex *index, size_t first, size_t last, double *length, double *area);
+
+/* @brief Calculates length & area of the part of a Curve between two x values
+ *
+ * The x values are found by binary search, whole segments are summed with
+ * the Curve's RangeIndex in O(log n) and the segments cut by the range
+ * are interpolated linearly. The RangeIndex is built on first use, and
+ * rebuilt only if the pending transform cannot be applied to its sums.
+ * @param *curve Target Curve
+ * @param fromX One end of the range
+ * @param toX Other end of the range
+ * @param *length Length of the curve inside the range
+ * @param *area Area under the curve inside the range
+ * @return Returns false if memory could not be allocated
+ * */
+bool curve_RangeStats(Curve *curve, double fromX, double toX, double *length, double *area);
+
+/* @brief Finds the first point at or past an x value by binary search
+ *
+ * Past means in the direction of the curve, so for shrinking x values it
+ * is the first point with x at or below the value.
+ * @param *curve Target Curve
+ * @param x Value of x to find
+ * @return Index of the point, size if every point is before x
+ * */
+size_t curve_FindX(Curve *curve, double x);
+#endif
@@ -0,0 +1,157 @@
+#include "curve.h"
+#include "simplify.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+/* @brief A run of points whose inner points are not decided yet
+ * */
+typedef struct
+{
+    size_t first;
+    size_t last;
+}SimplifyRange;
+
+/* @brief Finds the inner point furthest from the chord of a range
+ *
+ * Compares the cross product with the chord, which is the distance times
+ * the chord length, so the scan needs no square roots or divisions.
+ * Points are read through the pending transform, see curve_GetAt.
+ * @param *cross Filled with |cross product| of the furthest point
+ * @return Index of the furthest point
+ * */
+static size_t furthestPoint(Curve *curve, size_t first, size_t last, double *cross)
+{
+    Point start = curve_GetAt(curve, first);
+    Point end = curve_GetAt(curve, last);
+    Point point;
+    double dx = end.x - start.x;
+    double dy = end.y - start.y;
+    double value;
+    double best = -1;
+    size_t index, bestIndex = first + 1;
+    if (dx == 0 && dy == 0)
+    {
+        /* Closed chord, fall back to the distance from its end */
+        for (index = first + 1; index < last; index++)
+        {
+            point = curve_GetAt(curve, index);
+            value = hypot(point.x - start.x, point.y - start.y);
+            if (value > best)
+            {
+                best = value;
+                bestIndex = index;
+            }
+        }
+        *cross = best;
+        return bestIndex;
+    }
+    for (index = first + 1; index < last; index++)
+    {
+        point = curve_GetAt(curve, index);
+        value = fabs(dx * (point.y - start.y) - dy * (point.x - start.x));
+        if (value > best)
+        {
+            best = value;
+            bestIndex = index;
+        }
+    }
+    *cross = best / hypot(dx, dy);
+    return bestIndex;
+}
+
+bool curve_Simplify(Curve *curve, double tolerance, SimplifyInfo *info)
+{
+    SimplifyRange *stack, *grown;
+    SimplifyRange range;
+    uint8_t *keep;
+    size_t stackSize = 0;
+    size_t stackCapacity = 64;
+    size_t index, furthest, kept, bytes;
+    size_t width = curve_CoordinateBytes(curve);
+    double distance;
+    if (!curve->isAnalyzed)
+        initCurve(curve);
+    if (info != NULL)
+    {
+        info->removed = 0;
+        info->lengthBefore = curve->length;
+        info->lengthAfter = curve->length;
+        info->areaBefore = curve->area;
+        info->areaAfter = curve->area;
+        info->freedBytes = 0;
+    }
+    if (curve->size < 3)
+        return true;
+    keep = (uint8_t *) calloc((curve->size + 7) / 8, 1);
+    stack = (SimplifyRange *) malloc(stackCapacity * sizeof(SimplifyRange));
+    if (keep == NULL || stack == NULL)
+    {
+        free(keep);
+        free(stack);
+        return false;
+    }
+    keep[0] |= 1;
+    keep[(curve->size - 1) / 8] |= 1 << ((curve->size - 1) % 8);
+    stack[stackSize].first = 0;
+    stack[stackSize].last = curve->size - 1;
+    stackSize++;
+    while (stackSize > 0)
+    {
+        range = stack[--stackSize];
+        if (range.last - range.first < 2)
+            continue;
+        furthest = furthestPoint(curve, range.first, range.last, &distance);
+        if (!(distance > tolerance))
+            continue;
+        keep[furthest / 8] |= 1 << (furthest % 8);
+        if (stackSize + 2 > stackCapacity)
+        {
+            grown = (SimplifyRange *) realloc(stack, 2 * stackCapacity * sizeof(SimplifyRange));
+            if (grown == NULL)
+            {
+                free(keep);
+                free(stack);
+                return false;
+            }
+            stack = grown;
+            stackCapacity *= 2;
+        }
+        stack[stackSize].first = range.first;
+        stack[stackSize].last = furthest;
+        stack[stackSize + 1].first = furthest;
+        stack[stackSize + 1].last = range.last;
+        stackSize += 2;
+    }
+    /* Compact the kept points to the front, in order, as stored so a
+     * pending transform & the storage precision are kept */
+    kept = 0;
+    for (index = 0; index < curve->size; index++)
+    {
+        if (keep[index / 8] & (1 << (index % 8)))
+        {
+            memmove((char *) curve->xs + kept * width, (char *) curve->xs + index * width, width);
+            memmove((char *) curve->ys + kept * width, (char *) curve->ys + index * width, width);
+            kept++;
+        }
+    }
+    free(keep);
+    free(stack);
+    if (info != NULL)
+        info->removed = curve->size - kept;
+    curve->size = kept;
+    curve_Invalidate(curve);
+    /* The points are already simplified, so a failed shrink only keeps the
+     * spare memory */
+    bytes = curve_Bytes(curve);
+    if (kept < curve->capacity && curve_Shrink(curve) && info != NULL)
+        info->freedBytes = bytes - curve_Bytes(curve);
+    initCurve(curve);
+    if (info != NULL)
+    {
+        info->lengthAfter = curve->length;
+        info->areaAfter = curve->area;
+    }
+    return true;
+}
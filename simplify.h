@@ -0,0 +1,37 @@
+#include "curve.h"
+#ifndef SIMPLIFY_H
+    #define SIMPLIFY_H
+#include <stddef.h>
+#include <stdbool.h>
+
+/* @brief Result of a simplification
+ * */
+typedef struct
+{
+    /* Points removed from the curve */
+    size_t removed;
+    /* Length & area of the curve before & after */
+    double lengthBefore;
+    double lengthAfter;
+    double areaBefore;
+    double areaAfter;
+    /* Memory released by shrinking the coordinate arrays */
+    size_t freedBytes;
+}SimplifyInfo;
+
+/* @brief Removes points that lie within a tolerance of the simplified curve
+ *
+ * Ramer-Douglas-Peucker with an explicit stack, so deep curves cannot
+ * overflow the call stack. Every removed point is within tolerance of the
+ * segment that replaces it, the first & last points are always kept.
+ * The coordinate arrays are then shrunk to the kept points, see
+ * curve_Shrink.
+ * @param *curve Target Curve, a pending transform is kept & applied to
+ * the distances
+ * @param tolerance Largest distance of a removed point from the curve
+ * @param *info Filled with the result, may be NULL
+ * @return Returns false if memory could not be allocated, the Curve is
+ * then left as it was
+ * */
+bool curve_Simplify(Curve *curve, double tolerance, SimplifyInfo *info);
+#endif
@@ -0,0 +1,628 @@
+#define _POSIX_C_SOURCE 200809L
+#include "stats.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define STATS_X86
+    #include <immintrin.h>
+#endif
+
+/* Points per block of calcCurveStatsParallel, fixed so results do not
+ * depend on the thread count */
+#define STATS_BLOCK_SIZE (1 << 16)
+/* Fewest blocks worth starting threads for */
+#define STATS_MIN_PARALLEL_BLOCKS 8
+
+/* Thread count set by setStatsThreads, 0 if not set */
+static int statsThreads = 0;
+/* Kernels of calcCurveStats & calcCurveStatsNarrow & their name, picked
+ * once by initStatsKernel */
+static void (*statsKernel)(const double *, const double *, size_t, CurveStats *);
+static void (*narrowKernel)(const NarrowCoordinates *, size_t, size_t, CurveStats *);
+static const char *statsKernelName;
+static pthread_once_t statsKernelOnce = PTHREAD_ONCE_INIT;
+
+/* @brief Work shared by the threads of calcCurveStatsParallel
+ * */
+typedef struct
+{
+    const double *xs;
+    const double *ys;
+    /* Coordinates to widen instead of xs & ys, or NULL */
+    const NarrowCoordinates *narrow;
+    size_t count;
+    size_t blockCount;
+    /* Next block to take */
+    size_t nextBlock;
+    pthread_mutex_t lock;
+    /* One result per block */
+    CurveStats *results;
+}StatsJob;
+
+/* @brief Folds the points from start onwards into partial statistics
+ *
+ * Point start - 1 must already be folded in, segments are measured the
+ * same way as calcPointLength & calcPointArea.
+ * */
+static void foldScalar(const double *xs, const double *ys, size_t start, size_t count, CurveStats *stats)
+{
+    double dx, dy;
+    size_t index;
+    for (index = start; index < count; index++)
+    {
+        dx = xs[index - 1] - xs[index];
+        dy = ys[index - 1] - ys[index];
+        stats->length += sqrt(dx * dx + dy * dy);
+        stats->area += fabs(xs[index] - xs[index - 1]) * ((fabs(ys[index - 1]) + fabs(ys[index])) / 2);
+        if (ys[index] < ys[stats->lowIndex])
+            stats->lowIndex = index;
+        if (ys[index] > ys[stats->highIndex])
+            stats->highIndex = index;
+    }
+}
+
+/* @brief Finishes statistics a vector kernel left off at point start
+ *
+ * Segments up to point start are already measured, point start itself
+ * is only checked for the lowest & highest y.
+ * */
+static void foldTail(const double *xs, const double *ys, size_t start, size_t count, CurveStats *stats)
+{
+    if (start >= count)
+        return;
+    if (ys[start] < ys[stats->lowIndex])
+        stats->lowIndex = start;
+    if (ys[start] > ys[stats->highIndex])
+        stats->highIndex = start;
+    foldScalar(xs, ys, start + 1, count, stats);
+}
+
+/* @brief Gets one coordinate of NarrowCoordinates widened to double,
+ * before the transform
+ * */
+static inline double narrowValue(const NarrowCoordinates *coordinates, const void *values, size_t index)
+{
+    if (coordinates->isFixed)
+        return ((const int32_t *) values)[index] * coordinates->step;
+    return ((const float *) values)[index];
+}
+
+/* @brief Gets a transformed x of NarrowCoordinates
+ * */
+static inline double narrowX(const NarrowCoordinates *coordinates, size_t index)
+{
+    return narrowValue(coordinates, coordinates->xs, index) * coordinates->scaleX + coordinates->offsetX;
+}
+
+/* @brief Gets a transformed y of NarrowCoordinates
+ * */
+static inline double narrowY(const NarrowCoordinates *coordinates, size_t index)
+{
+    return narrowValue(coordinates, coordinates->ys, index) * coordinates->scaleY + coordinates->offsetY;
+}
+
+/* @brief As foldTail for NarrowCoordinates
+ *
+ * Indices are from first, as the statistics are.
+ * */
+static void foldNarrowTail(const NarrowCoordinates *coordinates, size_t first, size_t start, size_t count,
+                           CurveStats *stats)
+{
+    double x0 = 0, y0 = 0, x1, y1, dx, dy;
+    double lowY, highY;
+    size_t index;
+    if (start >= count)
+        return;
+    lowY = narrowY(coordinates, first + stats->lowIndex);
+    highY = narrowY(coordinates, first + stats->highIndex);
+    x1 = narrowX(coordinates, first + start);
+    y1 = narrowY(coordinates, first + start);
+    for (index = start; index < count; index++)
+    {
+        if (index > start)
+        {
+            x1 = narrowX(coordinates, first + index);
+            y1 = narrowY(coordinates, first + index);
+            dx = x0 - x1;
+            dy = y0 - y1;
+            stats->length += sqrt(dx * dx + dy * dy);
+            stats->area += fabs(x1 - x0) * ((fabs(y0) + fabs(y1)) / 2);
+        }
+        if (y1 < lowY)
+        {
+            lowY = y1;
+            stats->lowIndex = index;
+        }
+        if (y1 > highY)
+        {
+            highY = y1;
+            stats->highIndex = index;
+        }
+        x0 = x1;
+        y0 = y1;
+    }
+}
+
+/* @brief Picks the first extreme out of per-lane candidates
+ * @param *values Lane extremes
+ * @param *indices Lane indices
+ * @param lanes Number of lanes
+ * @param isLow True to pick the lowest, false for the highest
+ * @return Index of the first extreme
+ * */
+static size_t pickLane(const double *values, const double *indices, int lanes, bool isLow)
+{
+    int lane, best = 0;
+    for (lane = 1; lane < lanes; lane++)
+    {
+        if ((isLow ? values[lane] < values[best] : values[lane] > values[best])
+            || (values[lane] == values[best] && indices[lane] < indices[best]))
+            best = lane;
+    }
+    return (size_t) indices[best];
+}
+
+void calcCurveStatsScalar(const double *xs, const double *ys, size_t count, CurveStats *stats)
+{
+    stats->length = 0;
+    stats->area = 0;
+    stats->lowIndex = 0;
+    stats->highIndex = 0;
+    if (count > 0)
+        foldScalar(xs, ys, 1, count, stats);
+}
+
+/* @brief Reference version of calcCurveStatsNarrow
+ * */
+static void calcCurveStatsNarrowScalar(const NarrowCoordinates *coordinates, size_t first, size_t count,
+                                       CurveStats *stats)
+{
+    stats->length = 0;
+    stats->area = 0;
+    stats->lowIndex = 0;
+    stats->highIndex = 0;
+    foldNarrowTail(coordinates, first, 0, count, stats);
+}
+
+#ifdef STATS_X86
+/* @brief Running sums & extremes of the SSE2 kernels, one per lane
+ * */
+typedef struct
+{
+    __m128d length;
+    __m128d area;
+    __m128d lowValue;
+    __m128d highValue;
+    __m128d lowIndex;
+    __m128d highIndex;
+    __m128d indices;
+}Sse2Sums;
+
+__attribute__((target("sse2")))
+static inline void sse2_Start(Sse2Sums *sums, double firstY)
+{
+    sums->length = _mm_setzero_pd();
+    sums->area = _mm_setzero_pd();
+    sums->lowValue = _mm_set1_pd(firstY);
+    sums->highValue = sums->lowValue;
+    sums->lowIndex = _mm_setzero_pd();
+    sums->highIndex = sums->lowIndex;
+    sums->indices = _mm_set_pd(1, 0);
+}
+
+/* @brief Folds the two segments from x0, y0 to x1, y1 into the sums
+ * */
+__attribute__((target("sse2")))
+static inline void sse2_Step(Sse2Sums *sums, __m128d x0, __m128d x1, __m128d y0, __m128d y1)
+{
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    const __m128d half = _mm_set1_pd(0.5);
+    __m128d dx = _mm_sub_pd(x0, x1);
+    __m128d dy = _mm_sub_pd(y0, y1);
+    __m128d mask;
+    sums->length = _mm_add_pd(sums->length, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))));
+    sums->area = _mm_add_pd(sums->area, _mm_mul_pd(_mm_andnot_pd(signMask, dx),
+        _mm_mul_pd(_mm_add_pd(_mm_andnot_pd(signMask, y0), _mm_andnot_pd(signMask, y1)), half)));
+    mask = _mm_cmplt_pd(y0, sums->lowValue);
+    sums->lowValue = _mm_or_pd(_mm_and_pd(mask, y0), _mm_andnot_pd(mask, sums->lowValue));
+    sums->lowIndex = _mm_or_pd(_mm_and_pd(mask, sums->indices), _mm_andnot_pd(mask, sums->lowIndex));
+    mask = _mm_cmpgt_pd(y0, sums->highValue);
+    sums->highValue = _mm_or_pd(_mm_and_pd(mask, y0), _mm_andnot_pd(mask, sums->highValue));
+    sums->highIndex = _mm_or_pd(_mm_and_pd(mask, sums->indices), _mm_andnot_pd(mask, sums->highIndex));
+    sums->indices = _mm_add_pd(sums->indices, _mm_set1_pd(2));
+}
+
+/* @brief Combines the lanes of the sums into statistics
+ * */
+__attribute__((target("sse2")))
+static inline void sse2_Finish(Sse2Sums *sums, CurveStats *stats)
+{
+    double lanes[2], laneIndices[2];
+    _mm_storeu_pd(lanes, sums->length);
+    stats->length = lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, sums->area);
+    stats->area = lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, sums->lowValue);
+    _mm_storeu_pd(laneIndices, sums->lowIndex);
+    stats->lowIndex = pickLane(lanes, laneIndices, 2, true);
+    _mm_storeu_pd(lanes, sums->highValue);
+    _mm_storeu_pd(laneIndices, sums->highIndex);
+    stats->highIndex = pickLane(lanes, laneIndices, 2, false);
+}
+
+/* @brief SSE2 kernel, two segments per step
+ * */
+__attribute__((target("sse2")))
+static void calcCurveStatsSse2(const double *xs, const double *ys, size_t count, CurveStats *stats)
+{
+    Sse2Sums sums;
+    size_t index;
+    sse2_Start(&sums, ys[0]);
+    for (index = 0; index + 2 < count; index += 2)
+    {
+        sse2_Step(&sums, _mm_loadu_pd(xs + index), _mm_loadu_pd(xs + index + 1),
+                  _mm_loadu_pd(ys + index), _mm_loadu_pd(ys + index + 1));
+    }
+    sse2_Finish(&sums, stats);
+    foldTail(xs, ys, index, count, stats);
+}
+
+/* @brief Loads two narrow coordinates widened to double & transformed
+ * */
+__attribute__((target("sse2")))
+static inline __m128d sse2_LoadNarrow(const NarrowCoordinates *coordinates, const void *values, size_t index,
+                                      __m128d scale, __m128d offset)
+{
+    __m128i bits = _mm_loadl_epi64((const __m128i *) ((const int32_t *) values + index));
+    __m128d widened;
+    if (coordinates->isFixed)
+        widened = _mm_mul_pd(_mm_cvtepi32_pd(bits), _mm_set1_pd(coordinates->step));
+    else
+        widened = _mm_cvtps_pd(_mm_castsi128_ps(bits));
+    return _mm_add_pd(_mm_mul_pd(widened, scale), offset);
+}
+
+/* @brief SSE2 kernel of calcCurveStatsNarrow, two segments per step
+ * */
+__attribute__((target("sse2")))
+static void calcCurveStatsNarrowSse2(const NarrowCoordinates *coordinates, size_t first, size_t count,
+                                     CurveStats *stats)
+{
+    const __m128d scaleX = _mm_set1_pd(coordinates->scaleX);
+    const __m128d scaleY = _mm_set1_pd(coordinates->scaleY);
+    const __m128d offsetX = _mm_set1_pd(coordinates->offsetX);
+    const __m128d offsetY = _mm_set1_pd(coordinates->offsetY);
+    Sse2Sums sums;
+    size_t index;
+    sse2_Start(&sums, narrowY(coordinates, first));
+    for (index = 0; index + 2 < count; index += 2)
+    {
+        sse2_Step(&sums, sse2_LoadNarrow(coordinates, coordinates->xs, first + index, scaleX, offsetX),
+                  sse2_LoadNarrow(coordinates, coordinates->xs, first + index + 1, scaleX, offsetX),
+                  sse2_LoadNarrow(coordinates, coordinates->ys, first + index, scaleY, offsetY),
+                  sse2_LoadNarrow(coordinates, coordinates->ys, first + index + 1, scaleY, offsetY));
+    }
+    sse2_Finish(&sums, stats);
+    foldNarrowTail(coordinates, first, index, count, stats);
+}
+
+/* @brief Running sums & extremes of the AVX2 kernels, one per lane
+ * */
+typedef struct
+{
+    __m256d length;
+    __m256d area;
+    __m256d lowValue;
+    __m256d highValue;
+    __m256d lowIndex;
+    __m256d highIndex;
+    __m256d indices;
+}Avx2Sums;
+
+__attribute__((target("avx2")))
+static inline void avx2_Start(Avx2Sums *sums, double firstY)
+{
+    sums->length = _mm256_setzero_pd();
+    sums->area = _mm256_setzero_pd();
+    sums->lowValue = _mm256_set1_pd(firstY);
+    sums->highValue = sums->lowValue;
+    sums->lowIndex = _mm256_setzero_pd();
+    sums->highIndex = sums->lowIndex;
+    sums->indices = _mm256_set_pd(3, 2, 1, 0);
+}
+
+/* @brief Folds the four segments from x0, y0 to x1, y1 into the sums
+ * */
+__attribute__((target("avx2")))
+static inline void avx2_Step(Avx2Sums *sums, __m256d x0, __m256d x1, __m256d y0, __m256d y1)
+{
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    __m256d dx = _mm256_sub_pd(x0, x1);
+    __m256d dy = _mm256_sub_pd(y0, y1);
+    __m256d mask;
+    sums->length = _mm256_add_pd(sums->length,
+        _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))));
+    sums->area = _mm256_add_pd(sums->area, _mm256_mul_pd(_mm256_andnot_pd(signMask, dx),
+        _mm256_mul_pd(_mm256_add_pd(_mm256_andnot_pd(signMask, y0), _mm256_andnot_pd(signMask, y1)), half)));
+    mask = _mm256_cmp_pd(y0, sums->lowValue, _CMP_LT_OQ);
+    sums->lowValue = _mm256_blendv_pd(sums->lowValue, y0, mask);
+    sums->lowIndex = _mm256_blendv_pd(sums->lowIndex, sums->indices, mask);
+    mask = _mm256_cmp_pd(y0, sums->highValue, _CMP_GT_OQ);
+    sums->highValue = _mm256_blendv_pd(sums->highValue, y0, mask);
+    sums->highIndex = _mm256_blendv_pd(sums->highIndex, sums->indices, mask);
+    sums->indices = _mm256_add_pd(sums->indices, _mm256_set1_pd(4));
+}
+
+/* @brief Combines the lanes of the sums into statistics
+ * */
+__attribute__((target("avx2")))
+static inline void avx2_Finish(Avx2Sums *sums, CurveStats *stats)
+{
+    double lanes[4], laneIndices[4];
+    _mm256_storeu_pd(lanes, sums->length);
+    stats->length = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm256_storeu_pd(lanes, sums->area);
+    stats->area = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm256_storeu_pd(lanes, sums->lowValue);
+    _mm256_storeu_pd(laneIndices, sums->lowIndex);
+    stats->lowIndex = pickLane(lanes, laneIndices, 4, true);
+    _mm256_storeu_pd(lanes, sums->highValue);
+    _mm256_storeu_pd(laneIndices, sums->highIndex);
+    stats->highIndex = pickLane(lanes, laneIndices, 4, false);
+}
+
+/* @brief AVX2 kernel, four segments per step
+ * */
+__attribute__((target("avx2")))
+static void calcCurveStatsAvx2(const double *xs, const double *ys, size_t count, CurveStats *stats)
+{
+    Avx2Sums sums;
+    size_t index;
+    avx2_Start(&sums, ys[0]);
+    for (index = 0; index + 4 < count; index += 4)
+    {
+        avx2_Step(&sums, _mm256_loadu_pd(xs + index), _mm256_loadu_pd(xs + index + 1),
+                  _mm256_loadu_pd(ys + index), _mm256_loadu_pd(ys + index + 1));
+    }
+    avx2_Finish(&sums, stats);
+    foldTail(xs, ys, index, count, stats);
+}
+
+/* @brief Loads four narrow coordinates widened to double & transformed
+ * */
+__attribute__((target("avx2")))
+static inline __m256d avx2_LoadNarrow(const NarrowCoordinates *coordinates, const void *values, size_t index,
+                                      __m256d scale, __m256d offset)
+{
+    __m128i bits = _mm_loadu_si128((const __m128i *) ((const int32_t *) values + index));
+    __m256d widened;
+    if (coordinates->isFixed)
+        widened = _mm256_mul_pd(_mm256_cvtepi32_pd(bits), _mm256_set1_pd(coordinates->step));
+    else
+        widened = _mm256_cvtps_pd(_mm_castsi128_ps(bits));
+    return _mm256_add_pd(_mm256_mul_pd(widened, scale), offset);
+}
+
+/* @brief AVX2 kernel of calcCurveStatsNarrow, four segments per step
+ * from 16 bytes per coordinate array
+ * */
+__attribute__((target("avx2")))
+static void calcCurveStatsNarrowAvx2(const NarrowCoordinates *coordinates, size_t first, size_t count,
+                                     CurveStats *stats)
+{
+    const __m256d scaleX = _mm256_set1_pd(coordinates->scaleX);
+    const __m256d scaleY = _mm256_set1_pd(coordinates->scaleY);
+    const __m256d offsetX = _mm256_set1_pd(coordinates->offsetX);
+    const __m256d offsetY = _mm256_set1_pd(coordinates->offsetY);
+    Avx2Sums sums;
+    size_t index;
+    avx2_Start(&sums, narrowY(coordinates, first));
+    for (index = 0; index + 4 < count; index += 4)
+    {
+        avx2_Step(&sums, avx2_LoadNarrow(coordinates, coordinates->xs, first + index, scaleX, offsetX),
+                  avx2_LoadNarrow(coordinates, coordinates->xs, first + index + 1, scaleX, offsetX),
+                  avx2_LoadNarrow(coordinates, coordinates->ys, first + index, scaleY, offsetY),
+                  avx2_LoadNarrow(coordinates, coordinates->ys, first + index + 1, scaleY, offsetY));
+    }
+    avx2_Finish(&sums, stats);
+    foldNarrowTail(coordinates, first, index, count, stats);
+}
+#endif
+
+/* @brief Picks statsKernel, narrowKernel & statsKernelName for the
+ * processor
+ * */
+static void initStatsKernel()
+{
+#ifdef STATS_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        statsKernel = calcCurveStatsAvx2;
+        narrowKernel = calcCurveStatsNarrowAvx2;
+        statsKernelName = "avx2";
+        return;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        statsKernel = calcCurveStatsSse2;
+        narrowKernel = calcCurveStatsNarrowSse2;
+        statsKernelName = "sse2";
+        return;
+    }
+#endif
+    statsKernel = calcCurveStatsScalar;
+    narrowKernel = calcCurveStatsNarrowScalar;
+    statsKernelName = "scalar";
+}
+
+void calcCurveStats(const double *xs, const double *ys, size_t count, CurveStats *stats)
+{
+    if (count == 0)
+    {
+        calcCurveStatsScalar(xs, ys, count, stats);
+        return;
+    }
+    pthread_once(&statsKernelOnce, initStatsKernel);
+    statsKernel(xs, ys, count, stats);
+}
+
+void calcCurveStatsNarrow(const NarrowCoordinates *coordinates, size_t first, size_t count, CurveStats *stats)
+{
+    if (count == 0)
+    {
+        calcCurveStatsNarrowScalar(coordinates, first, count, stats);
+        return;
+    }
+    pthread_once(&statsKernelOnce, initStatsKernel);
+    narrowKernel(coordinates, first, count, stats);
+}
+
+const char *calcCurveStatsKernel()
+{
+    pthread_once(&statsKernelOnce, initStatsKernel);
+    return statsKernelName;
+}
+
+/* @brief Calculates the statistics of one block of a StatsJob
+ * */
+static void statsJob_Block(StatsJob *job, size_t block)
+{
+    size_t start = block * STATS_BLOCK_SIZE;
+    size_t end = start + STATS_BLOCK_SIZE;
+    if (end > job->count)
+        end = job->count;
+    /* Start one point early to measure the segment between blocks */
+    if (start > 0)
+        start--;
+    if (job->narrow != NULL)
+        calcCurveStatsNarrow(job->narrow, start, end - start, &job->results[block]);
+    else
+        calcCurveStats(job->xs + start, job->ys + start, end - start, &job->results[block]);
+    job->results[block].lowIndex += start;
+    job->results[block].highIndex += start;
+}
+
+/* @brief Thread body, takes blocks until none are left
+ * */
+static void *statsJob_Run(void *argument)
+{
+    StatsJob *job = (StatsJob *) argument;
+    size_t block;
+    for (;;)
+    {
+        pthread_mutex_lock(&job->lock);
+        block = job->nextBlock++;
+        pthread_mutex_unlock(&job->lock);
+        if (block >= job->blockCount)
+            break;
+        statsJob_Block(job, block);
+    }
+    return NULL;
+}
+
+/* @brief Gets a transformed y of a StatsJob
+ * */
+static double statsJob_Y(StatsJob *job, size_t index)
+{
+    return job->narrow != NULL ? narrowY(job->narrow, index) : job->ys[index];
+}
+
+/* @brief Runs a StatsJob over its blocks & combines them in order
+ * @return Returns false, with nothing calculated, if memory could not be
+ * allocated or the job is a single block
+ * */
+static bool statsJob_Parallel(StatsJob *job, int threads, CurveStats *stats)
+{
+    pthread_t *workers;
+    size_t block;
+    int started = 0, loopVar;
+    if (threads <= 0)
+        threads = getStatsThreads();
+    job->blockCount = (job->count + STATS_BLOCK_SIZE - 1) / STATS_BLOCK_SIZE;
+    job->nextBlock = 0;
+    job->results = (CurveStats *) malloc(job->blockCount * sizeof(CurveStats));
+    if (job->blockCount <= 1 || job->results == NULL)
+    {
+        free(job->results);
+        return false;
+    }
+    pthread_mutex_init(&job->lock, NULL);
+    if ((size_t) threads > job->blockCount)
+        threads = (int) job->blockCount;
+    if (job->blockCount < STATS_MIN_PARALLEL_BLOCKS)
+        threads = 1;
+    workers = (pthread_t *) malloc(threads * sizeof(pthread_t));
+    if (workers != NULL)
+    {
+        /* The calling thread is a worker too */
+        for (loopVar = 1; loopVar < threads; loopVar++)
+        {
+            if (pthread_create(&workers[started], NULL, statsJob_Run, job) == 0)
+                started++;
+        }
+    }
+    statsJob_Run(job);
+    for (loopVar = 0; loopVar < started; loopVar++)
+        pthread_join(workers[loopVar], NULL);
+    free(workers);
+    pthread_mutex_destroy(&job->lock);
+    /* Combine in block order, ties keep the earlier block */
+    *stats = job->results[0];
+    for (block = 1; block < job->blockCount; block++)
+    {
+        stats->length += job->results[block].length;
+        stats->area += job->results[block].area;
+        if (statsJob_Y(job, job->results[block].lowIndex) < statsJob_Y(job, stats->lowIndex))
+            stats->lowIndex = job->results[block].lowIndex;
+        if (statsJob_Y(job, job->results[block].highIndex) > statsJob_Y(job, stats->highIndex))
+            stats->highIndex = job->results[block].highIndex;
+    }
+    free(job->results);
+    return true;
+}
+
+void calcCurveStatsParallel(const double *xs, const double *ys, size_t count, int threads, CurveStats *stats)
+{
+    StatsJob job;
+    job.xs = xs;
+    job.ys = ys;
+    job.narrow = NULL;
+    job.count = count;
+    if (!statsJob_Parallel(&job, threads, stats))
+        calcCurveStats(xs, ys, count, stats);
+}
+
+void calcCurveStatsNarrowParallel(const NarrowCoordinates *coordinates, size_t count, int threads,
+                                  CurveStats *stats)
+{
+    StatsJob job;
+    job.xs = NULL;
+    job.ys = NULL;
+    job.narrow = coordinates;
+    job.count = count;
+    if (!statsJob_Parallel(&job, threads, stats))
+        calcCurveStatsNarrow(coordinates, 0, count, stats);
+}
+
+int getStatsThreads()
+{
+    const char *setting;
+    long threads;
+    if (statsThreads > 0)
+        return statsThreads;
+    setting = getenv("NCURVECALC_THREADS");
+    if (setting != NULL && atoi(setting) > 0)
+        return atoi(setting);
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+    return threads > 0 ? (int) threads : 1;
+}
+
+void setStatsThreads(int threads)
+{
+    statsThreads = threads > 0 ? threads : 0;
+}
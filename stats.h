@@ -0,0 +1,112 @@
+#ifndef STATS_H
+    #define STATS_H
+#include <stddef.h>
+#include <stdbool.h>
+
+/* @brief Statistics of a run of points, see calcCurveStats
+ * */
+typedef struct
+{
+    /* Sum of the segment lengths */
+    double length;
+    /* Sum of the segment areas, as calcPointArea */
+    double area;
+    /* Index of the first lowest y */
+    size_t lowIndex;
+    /* Index of the first highest y */
+    size_t highIndex;
+}CurveStats;
+
+/* @brief Coordinates stored as floats or 32 bit integers
+ *
+ * A stored value v stands for (v * step) * scale + offset, with scale &
+ * offset of its axis. The kernels widen each value to double as they
+ * load it, so half the memory of doubles is read for the same result.
+ * */
+typedef struct
+{
+    /* Stored coordinates, int32_t if isFixed, else float */
+    const void *xs;
+    const void *ys;
+    bool isFixed;
+    /* Step of int32_t values, ignored for floats */
+    double step;
+    /* Transform applied after widening */
+    double scaleX;
+    double scaleY;
+    double offsetX;
+    double offsetY;
+}NarrowCoordinates;
+
+/* @brief Calculates length, area, lowest & highest point in one pass
+ *
+ * Uses the widest vector kernel the processor supports (AVX2, SSE2 or
+ * plain C), picked once at the first call. Sums are accumulated per
+ * vector lane, so they may differ from calcCurveStatsScalar in the last
+ * bits but never between runs.
+ * @param *xs X coordinates
+ * @param *ys Y coordinates
+ * @param count Number of points
+ * @param *stats Result, all zero for an empty run
+ * */
+void calcCurveStats(const double *xs, const double *ys, size_t count, CurveStats *stats);
+
+/* @brief Reference version of calcCurveStats, one segment at a time
+ * @param *xs X coordinates
+ * @param *ys Y coordinates
+ * @param count Number of points
+ * @param *stats Result, all zero for an empty run
+ * */
+void calcCurveStatsScalar(const double *xs, const double *ys, size_t count, CurveStats *stats);
+
+/* @brief Calculates curve statistics with several threads
+ *
+ * The points are cut into fixed blocks, each block also measures the
+ * segment joining it to the block before. Block results are combined in
+ * order, so the result is the same for any number of threads.
+ * @param *xs X coordinates
+ * @param *ys Y coordinates
+ * @param count Number of points
+ * @param threads Number of threads, 0 for getStatsThreads
+ * @param *stats Result, all zero for an empty run
+ * */
+void calcCurveStatsParallel(const double *xs, const double *ys, size_t count, int threads, CurveStats *stats);
+
+/* @brief As calcCurveStats for coordinates stored as floats or integers
+ *
+ * Picks its kernel with calcCurveStats, accumulates in double.
+ * @param *coordinates Stored coordinates
+ * @param first Index of the first point
+ * @param count Number of points
+ * @param *stats Result, indices counted from first
+ * */
+void calcCurveStatsNarrow(const NarrowCoordinates *coordinates, size_t first, size_t count, CurveStats *stats);
+
+/* @brief As calcCurveStatsParallel for coordinates stored as floats or
+ * integers
+ * @param *coordinates Stored coordinates
+ * @param count Number of points
+ * @param threads Number of threads, 0 for getStatsThreads
+ * @param *stats Result, all zero for an empty run
+ * */
+void calcCurveStatsNarrowParallel(const NarrowCoordinates *coordinates, size_t count, int threads,
+                                  CurveStats *stats);
+
+/* @brief Gets the number of threads used for curve statistics & text parsing
+ *
+ * Set by setStatsThreads, else the NCURVECALC_THREADS environment
+ * variable, else the number of online processors.
+ * @return Number of threads, at least 1
+ * */
+int getStatsThreads();
+
+/* @brief Sets the number of threads used for curve statistics
+ * @param threads Number of threads, 0 to go back to the default
+ * */
+void setStatsThreads(int threads);
+
+/* @brief Gets the name of the kernel calcCurveStats uses
+ * @return "avx2", "sse2" or "scalar"
+ * */
+const char *calcCurveStatsKernel();
+#endif
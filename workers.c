@@ -0,0 +1,303 @@
+#define _POSIX_C_SOURCE 200809L
+#include "workers.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+/* Tasks a queue holds before it first grows */
+#define WORKER_QUEUE_SIZE 64
+
+/* @brief A queued task
+ * */
+typedef struct
+{
+    WorkerTask task;
+    void *argument;
+}WorkerJob;
+
+/* @brief Ring buffer of tasks owned by one thread
+ *
+ * The owner takes from the back, thieves take from the front.
+ * */
+typedef struct
+{
+    WorkerJob *jobs;
+    size_t front;
+    size_t count;
+    size_t capacity;
+    pthread_mutex_t lock;
+}WorkerQueue;
+
+/* @brief A thread of a WorkerPool
+ * */
+typedef struct
+{
+    struct WorkerPool *pool;
+    int index;
+    pthread_t thread;
+}Worker;
+
+struct WorkerPool
+{
+    Worker *workers;
+    WorkerQueue *queues;
+    /* Queues allocated, threads started */
+    int queueCount;
+    int threads;
+    /* Guards the counters below & the conditions */
+    pthread_mutex_t lock;
+    pthread_cond_t hasWork;
+    pthread_cond_t isIdle;
+    /* Tasks queued & not yet taken */
+    size_t queued;
+    /* Tasks submitted & not yet finished */
+    size_t pending;
+    /* Queue for submits from outside the pool */
+    unsigned int nextQueue;
+    bool isStopping;
+};
+
+/* Worker of the calling thread, NULL outside a WorkerPool */
+static pthread_key_t currentWorker;
+static pthread_once_t currentWorkerOnce = PTHREAD_ONCE_INIT;
+
+static void initCurrentWorker()
+{
+    pthread_key_create(&currentWorker, NULL);
+}
+
+/* @brief Adds a task to the back of a queue
+ * @return Returns false if memory could not be allocated
+ * */
+static bool queue_Push(WorkerQueue *queue, WorkerJob job)
+{
+    WorkerJob *jobs;
+    size_t index;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count == queue->capacity)
+    {
+        jobs = (WorkerJob *) malloc(2 * queue->capacity * sizeof(WorkerJob));
+        if (jobs == NULL)
+        {
+            pthread_mutex_unlock(&queue->lock);
+            return false;
+        }
+        for (index = 0; index < queue->count; index++)
+            jobs[index] = queue->jobs[(queue->front + index) % queue->capacity];
+        free(queue->jobs);
+        queue->jobs = jobs;
+        queue->front = 0;
+        queue->capacity *= 2;
+    }
+    queue->jobs[(queue->front + queue->count) % queue->capacity] = job;
+    queue->count++;
+    pthread_mutex_unlock(&queue->lock);
+    return true;
+}
+
+/* @brief Takes a task from the back or the front of a queue
+ * @return Returns false if the queue is empty
+ * */
+static bool queue_Take(WorkerQueue *queue, bool isBack, WorkerJob *job)
+{
+    bool isTaken = false;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count > 0)
+    {
+        if (isBack)
+        {
+            *job = queue->jobs[(queue->front + queue->count - 1) % queue->capacity];
+        }
+        else
+        {
+            *job = queue->jobs[queue->front];
+            queue->front = (queue->front + 1) % queue->capacity;
+        }
+        queue->count--;
+        isTaken = true;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return isTaken;
+}
+
+/* @brief Takes the newest own task or steals the oldest task of another
+ * thread
+ * @return Returns false if every queue is empty
+ * */
+static bool worker_Find(Worker *worker, WorkerJob *job)
+{
+    WorkerPool *pool = worker->pool;
+    int offset;
+    if (queue_Take(&pool->queues[worker->index], true, job))
+        return true;
+    for (offset = 1; offset < pool->threads; offset++)
+    {
+        if (queue_Take(&pool->queues[(worker->index + offset) % pool->threads], false, job))
+            return true;
+    }
+    return false;
+}
+
+/* @brief Thread body, runs tasks until the pool stops
+ * */
+static void *worker_Run(void *argument)
+{
+    Worker *worker = (Worker *) argument;
+    WorkerPool *pool = worker->pool;
+    WorkerJob job;
+    pthread_setspecific(currentWorker, worker);
+    pthread_mutex_lock(&pool->lock);
+    while (true)
+    {
+        while (pool->queued == 0 && !pool->isStopping)
+            pthread_cond_wait(&pool->hasWork, &pool->lock);
+        if (pool->queued == 0 && pool->isStopping)
+            break;
+        pthread_mutex_unlock(&pool->lock);
+        if (!worker_Find(worker, &job))
+        {
+            /* Counted but not pushed yet or taken by another thread */
+            pthread_mutex_lock(&pool->lock);
+            continue;
+        }
+        pthread_mutex_lock(&pool->lock);
+        pool->queued--;
+        pthread_mutex_unlock(&pool->lock);
+        job.task(job.argument);
+        pthread_mutex_lock(&pool->lock);
+        pool->pending--;
+        if (pool->pending == 0)
+            pthread_cond_broadcast(&pool->isIdle);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+WorkerPool *mkWorkerPool(int threads)
+{
+    WorkerPool *pool;
+    int index;
+    pthread_once(&currentWorkerOnce, initCurrentWorker);
+    if (threads <= 0)
+        threads = getStatsThreads();
+    pool = (WorkerPool *) malloc(sizeof(WorkerPool));
+    if (pool == NULL)
+        return NULL;
+    pool->workers = (Worker *) malloc(threads * sizeof(Worker));
+    pool->queues = (WorkerQueue *) calloc(threads, sizeof(WorkerQueue));
+    if (pool->workers == NULL || pool->queues == NULL)
+    {
+        free(pool->workers);
+        free(pool->queues);
+        free(pool);
+        return NULL;
+    }
+    pool->queueCount = threads;
+    for (index = 0; index < threads; index++)
+    {
+        pool->queues[index].jobs = (WorkerJob *) malloc(WORKER_QUEUE_SIZE * sizeof(WorkerJob));
+        pool->queues[index].capacity = WORKER_QUEUE_SIZE;
+        pthread_mutex_init(&pool->queues[index].lock, NULL);
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->hasWork, NULL);
+    pthread_cond_init(&pool->isIdle, NULL);
+    pool->queued = 0;
+    pool->pending = 0;
+    pool->nextQueue = 0;
+    pool->isStopping = false;
+    pool->threads = 0;
+    for (index = 0; index < threads; index++)
+    {
+        if (pool->queues[index].jobs == NULL)
+            break;
+        pool->workers[index].pool = pool;
+        pool->workers[index].index = index;
+        if (pthread_create(&pool->workers[index].thread, NULL, worker_Run, &pool->workers[index]) != 0)
+            break;
+        pool->threads++;
+    }
+    if (pool->threads == 0)
+    {
+        rmWorkerPool(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void rmWorkerPool(WorkerPool *pool)
+{
+    int index;
+    if (pool == NULL)
+        return;
+    workerPool_Wait(pool);
+    pthread_mutex_lock(&pool->lock);
+    pool->isStopping = true;
+    pthread_cond_broadcast(&pool->hasWork);
+    pthread_mutex_unlock(&pool->lock);
+    for (index = 0; index < pool->threads; index++)
+        pthread_join(pool->workers[index].thread, NULL);
+    for (index = 0; index < pool->queueCount; index++)
+    {
+        free(pool->queues[index].jobs);
+        pthread_mutex_destroy(&pool->queues[index].lock);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->hasWork);
+    pthread_cond_destroy(&pool->isIdle);
+    free(pool->workers);
+    free(pool->queues);
+    free(pool);
+}
+
+bool workerPool_Submit(WorkerPool *pool, WorkerTask task, void *argument)
+{
+    Worker *worker = (Worker *) pthread_getspecific(currentWorker);
+    WorkerJob job;
+    int index;
+    job.task = task;
+    job.argument = argument;
+    if (worker != NULL && worker->pool == pool)
+    {
+        index = worker->index;
+    }
+    else
+    {
+        pthread_mutex_lock(&pool->lock);
+        index = pool->nextQueue++ % pool->threads;
+        pthread_mutex_unlock(&pool->lock);
+    }
+    /* Counted before the push so a thread taking the task straight away
+     * never sees the counters behind */
+    pthread_mutex_lock(&pool->lock);
+    pool->pending++;
+    pool->queued++;
+    pthread_mutex_unlock(&pool->lock);
+    if (!queue_Push(&pool->queues[index], job))
+    {
+        pthread_mutex_lock(&pool->lock);
+        pool->pending--;
+        pool->queued--;
+        if (pool->pending == 0)
+            pthread_cond_broadcast(&pool->isIdle);
+        pthread_mutex_unlock(&pool->lock);
+        return false;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->hasWork);
+    pthread_mutex_unlock(&pool->lock);
+    return true;
+}
+
+void workerPool_Wait(WorkerPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+        pthread_cond_wait(&pool->isIdle, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int workerPool_Threads(WorkerPool *pool)
+{
+    return pool->threads;
+}
@@ -0,0 +1,48 @@
+#ifndef WORKERS_H
+    #define WORKERS_H
+#include <stdbool.h>
+
+/* @brief Work run by a WorkerPool thread
+ * @param *argument Value given to workerPool_Submit
+ * */
+typedef void (*WorkerTask)(void *argument);
+
+/* @brief Fixed set of threads running submitted tasks
+ *
+ * Every thread has its own queue. A thread runs its newest task first and
+ * when its queue is empty steals the oldest task of another thread, so
+ * uneven tasks spread over every thread. Tasks submitted by a task go to
+ * the queue of the thread running it.
+ * */
+typedef struct WorkerPool WorkerPool;
+
+/* @brief Starts a WorkerPool
+ * @param threads Number of threads, 0 for getStatsThreads
+ * @return Memory of new WorkerPool or NULL
+ * */
+WorkerPool *mkWorkerPool(int threads);
+
+/* @brief Waits for every task, then stops & frees a WorkerPool
+ * @param *pool Target WorkerPool, may be NULL
+ * */
+void rmWorkerPool(WorkerPool *pool);
+
+/* @brief Queues a task
+ * @param *pool Target WorkerPool
+ * @param task Function to run
+ * @param *argument Passed to task
+ * @return Returns false if memory could not be allocated
+ * */
+bool workerPool_Submit(WorkerPool *pool, WorkerTask task, void *argument);
+
+/* @brief Waits until every submitted task has finished
+ * @param *pool Target WorkerPool
+ * */
+void workerPool_Wait(WorkerPool *pool);
+
+/* @brief Gets the number of threads of a WorkerPool
+ * @param *pool Target WorkerPool
+ * @return Number of threads
+ * */
+int workerPool_Threads(WorkerPool *pool);
+#endif
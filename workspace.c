@@ -0,0 +1,386 @@
+#define _POSIX_C_SOURCE 200809L
+#include "workspace.h"
+#include "perf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/* @brief Operation run on each curve by workspace_Run
+ * */
+typedef enum
+{
+    WORKSPACE_LOAD,
+    WORKSPACE_ANALYZE,
+    WORKSPACE_SAVE,
+    WORKSPACE_PACK
+}WorkspaceOperation;
+
+/* @brief Argument of one curve task
+ * */
+typedef struct
+{
+    WorkspaceEntry *entry;
+    WorkspaceOperation operation;
+    /* Output directory & durability of WORKSPACE_SAVE */
+    const char *directory;
+    bool isDurable;
+}WorkspaceTask;
+
+/* region: Helpers */
+
+/* @brief Copies a string to new memory
+ * @return New string or NULL
+ * */
+static char *copyString(const char *text)
+{
+    size_t length = strlen(text) + 1;
+    char *copy = (char *) malloc(length);
+    if (copy != NULL)
+        memcpy(copy, text, length);
+    return copy;
+}
+
+/* @brief Orders file names for qsort
+ * */
+static int compareNames(const void *left, const void *right)
+{
+    return strcmp(*(char * const *) left, *(char * const *) right);
+}
+
+/* @brief Gets the part of a path after the last slash
+ * */
+static const char *baseName(const char *fileName)
+{
+    const char *slash = strrchr(fileName, '/');
+    return slash == NULL ? fileName : slash + 1;
+}
+
+/* @brief Saves one curve under its base name in a directory
+ * @return Returns false if the file exists or could not be written
+ * */
+static bool saveEntry(WorkspaceEntry *entry, const char *directory, bool isDurable)
+{
+    struct stat fileTest;
+    char *fileName;
+    size_t length;
+    bool isSaved;
+    length = strlen(directory) + strlen(baseName(entry->fileName)) + 2;
+    fileName = (char *) malloc(length);
+    if (fileName == NULL)
+        return false;
+    snprintf(fileName, length, "%s/%s", directory, baseName(entry->fileName));
+    if (stat(fileName, &fileTest) == 0)
+        isSaved = false;
+    else if (entry->packed != NULL && isBinaryName(fileName))
+        isSaved = packedCurve_SaveBinary(entry->packed, fileName, isDurable);
+    else if (entry->packed != NULL)
+        isSaved = packedCurve_SaveText(entry->packed, fileName, isDurable);
+    else if (isBinaryName(fileName))
+        isSaved = curve_SaveBinary(entry->curve, fileName, isDurable);
+    else
+        isSaved = curve_SaveText(entry->curve, fileName, isDurable);
+    free(fileName);
+    return isSaved;
+}
+
+/* @brief Runs one operation on one curve, WorkerTask of workspace_Run
+ * */
+static void runTask(void *argument)
+{
+    WorkspaceTask *task = (WorkspaceTask *) argument;
+    WorkspaceEntry *entry = task->entry;
+    double startTime = perf_Start();
+    switch (task->operation)
+    {
+        case WORKSPACE_LOAD:
+            rmPackedCurve(entry->packed);
+            entry->packed = NULL;
+            curve_Clear(entry->curve);
+            entry->status = curve_LoadFileThreads(entry->curve, entry->fileName, NULL, 1);
+            entry->isLoaded = entry->status == LOAD_OK;
+            entry->isSaved = true;
+            break;
+        case WORKSPACE_ANALYZE:
+            if (entry->packed != NULL)
+                packedCurve_Analyze(entry->packed);
+            else
+                curve_Analyze(entry->curve, 1);
+            break;
+        case WORKSPACE_SAVE:
+            entry->isSaved = saveEntry(entry, task->directory, task->isDurable);
+            break;
+        case WORKSPACE_PACK:
+            if (entry->packed == NULL)
+            {
+                entry->packed = mkPackedCurve(entry->curve);
+                if (entry->packed != NULL)
+                    curve_Clear(entry->curve);
+            }
+            break;
+    }
+    entry->seconds = perf_Start() - startTime;
+}
+
+/* @brief Runs an operation on every curve of a Workspace & waits for it
+ *
+ * Only loaded curves are analyzed, saved or packed.
+ * */
+static void workspace_Run(Workspace *workspace, WorkspaceOperation operation, const char *directory, bool isDurable)
+{
+    WorkspaceTask *tasks;
+    WorkspaceTask single;
+    size_t index;
+    tasks = (WorkspaceTask *) malloc(workspace->count * sizeof(WorkspaceTask));
+    for (index = 0; index < workspace->count; index++)
+    {
+        if (operation != WORKSPACE_LOAD && !workspace->entries[index].isLoaded)
+            continue;
+        if (tasks != NULL)
+        {
+            tasks[index].entry = &workspace->entries[index];
+            tasks[index].operation = operation;
+            tasks[index].directory = directory;
+            tasks[index].isDurable = isDurable;
+            if (workerPool_Submit(workspace->pool, runTask, &tasks[index]))
+                continue;
+        }
+        /* Out of memory, run in the calling thread instead */
+        single.entry = &workspace->entries[index];
+        single.operation = operation;
+        single.directory = directory;
+        single.isDurable = isDurable;
+        runTask(&single);
+    }
+    workerPool_Wait(workspace->pool);
+    free(tasks);
+}
+/* endregion */
+
+/* region: Workspace */
+
+Workspace *mkWorkspace(int threads)
+{
+    Workspace *workspace = (Workspace *) malloc(sizeof(Workspace));
+    if (workspace == NULL)
+        return NULL;
+    workspace->entries = NULL;
+    workspace->count = 0;
+    workspace->capacity = 0;
+    workspace->pool = mkWorkerPool(threads);
+    if (workspace->pool == NULL)
+    {
+        free(workspace);
+        return NULL;
+    }
+    return workspace;
+}
+
+void rmWorkspace(Workspace *workspace)
+{
+    size_t index;
+    if (workspace == NULL)
+        return;
+    rmWorkerPool(workspace->pool);
+    for (index = 0; index < workspace->count; index++)
+    {
+        free(workspace->entries[index].fileName);
+        rmCurve(workspace->entries[index].curve);
+        rmPackedCurve(workspace->entries[index].packed);
+    }
+    free(workspace->entries);
+    free(workspace);
+}
+
+bool workspace_Add(Workspace *workspace, const char *fileName)
+{
+    WorkspaceEntry *entries;
+    WorkspaceEntry *entry;
+    size_t capacity;
+    if (workspace->count == workspace->capacity)
+    {
+        capacity = workspace->capacity == 0 ? 16 : 2 * workspace->capacity;
+        entries = (WorkspaceEntry *) realloc(workspace->entries, capacity * sizeof(WorkspaceEntry));
+        if (entries == NULL)
+            return false;
+        workspace->entries = entries;
+        workspace->capacity = capacity;
+    }
+    entry = &workspace->entries[workspace->count];
+    entry->fileName = copyString(fileName);
+    entry->curve = mkCurve();
+    if (entry->fileName == NULL || entry->curve == NULL)
+    {
+        free(entry->fileName);
+        rmCurve(entry->curve);
+        return false;
+    }
+    entry->packed = NULL;
+    entry->status = LOAD_OK;
+    entry->isLoaded = false;
+    entry->isSaved = true;
+    entry->seconds = 0;
+    workspace->count++;
+    return true;
+}
+
+int workspace_AddDirectory(Workspace *workspace, const char *directory)
+{
+    DIR *folder;
+    struct dirent *item;
+    struct stat fileStat;
+    char **names = NULL;
+    char **grown;
+    char *fileName;
+    size_t count = 0, capacity = 0, length, index;
+    int added = 0;
+    folder = opendir(directory);
+    if (folder == NULL)
+        return -1;
+    while ((item = readdir(folder)) != NULL)
+    {
+        if (item->d_name[0] == '.')
+            continue;
+        length = strlen(directory) + strlen(item->d_name) + 2;
+        fileName = (char *) malloc(length);
+        if (fileName == NULL)
+            break;
+        snprintf(fileName, length, "%s/%s", directory, item->d_name);
+        if (stat(fileName, &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+        {
+            free(fileName);
+            continue;
+        }
+        if (count == capacity)
+        {
+            capacity = capacity == 0 ? 16 : 2 * capacity;
+            grown = (char **) realloc(names, capacity * sizeof(char *));
+            if (grown == NULL)
+            {
+                free(fileName);
+                break;
+            }
+            names = grown;
+        }
+        names[count++] = fileName;
+    }
+    closedir(folder);
+    qsort(names, count, sizeof(char *), compareNames);
+    for (index = 0; index < count; index++)
+    {
+        if (workspace_Add(workspace, names[index]))
+            added++;
+        free(names[index]);
+    }
+    free(names);
+    return added;
+}
+
+size_t workspace_Load(Workspace *workspace)
+{
+    size_t index, loaded = 0;
+    workspace_Run(workspace, WORKSPACE_LOAD, NULL, false);
+    for (index = 0; index < workspace->count; index++)
+    {
+        if (workspace->entries[index].isLoaded)
+            loaded++;
+    }
+    return loaded;
+}
+
+void workspace_Analyze(Workspace *workspace)
+{
+    workspace_Run(workspace, WORKSPACE_ANALYZE, NULL, false);
+}
+
+void workspace_Shift(Workspace *workspace, double shiftX, double shiftY)
+{
+    size_t index;
+    /* Shifts are O(1) per curve, not worth a task */
+    for (index = 0; index < workspace->count; index++)
+    {
+        if (!workspace->entries[index].isLoaded)
+            continue;
+        if (workspace->entries[index].packed != NULL)
+            packedCurve_Transform(workspace->entries[index].packed, 1, 1, shiftX, shiftY);
+        else
+            mvCurve(workspace->entries[index].curve, shiftX, shiftY);
+    }
+}
+
+size_t workspace_Save(Workspace *workspace, const char *directory, bool isDurable)
+{
+    size_t index, failures = 0;
+    workspace_Run(workspace, WORKSPACE_SAVE, directory, isDurable);
+    for (index = 0; index < workspace->count; index++)
+    {
+        if (workspace->entries[index].isLoaded && !workspace->entries[index].isSaved)
+            failures++;
+    }
+    return failures;
+}
+
+size_t workspace_Pack(Workspace *workspace)
+{
+    size_t index, failures = 0;
+    workspace_Run(workspace, WORKSPACE_PACK, NULL, false);
+    for (index = 0; index < workspace->count; index++)
+    {
+        if (workspace->entries[index].isLoaded && workspace->entries[index].packed == NULL)
+            failures++;
+    }
+    return failures;
+}
+
+size_t workspaceEntry_Points(WorkspaceEntry *entry)
+{
+    return entry->packed != NULL ? entry->packed->count : entry->curve->size;
+}
+
+size_t workspaceEntry_Bytes(WorkspaceEntry *entry)
+{
+    if (entry->packed != NULL)
+        return packedCurve_Bytes(entry->packed);
+    return curve_Bytes(entry->curve);
+}
+
+bool workspaceEntry_Stats(WorkspaceEntry *entry, double *length, double *area)
+{
+    if (entry->packed != NULL)
+    {
+        *length = entry->packed->length;
+        *area = entry->packed->area;
+        return entry->packed->isAnalyzed;
+    }
+    *length = entry->curve->length;
+    *area = entry->curve->area;
+    return entry->curve->isAnalyzed;
+}
+
+const char *workspaceEntry_Status(WorkspaceEntry *entry)
+{
+    if (!entry->isSaved)
+        return "save failed";
+    switch (entry->status)
+    {
+        case LOAD_NOFILE:
+            return "unreadable";
+        case LOAD_NOMEMORY:
+            return "no memory";
+        case LOAD_SEQUENCE:
+            return "not sequential";
+        case LOAD_FORMAT:
+            return "bad format";
+        case LOAD_CANCELLED:
+            return "cancelled";
+        case LOAD_RANGE:
+            return "out of range";
+        default:
+            break;
+    }
+    if (entry->packed != NULL)
+        return "packed";
+    return entry->isLoaded ? "loaded" : "not loaded";
+}
+/* endregion */
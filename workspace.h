@@ -0,0 +1,130 @@
+#include "curve.h"
+#include "curveio.h"
+#include "workers.h"
+#include "packed.h"
+#ifndef WORKSPACE_H
+    #define WORKSPACE_H
+#include <stddef.h>
+#include <stdbool.h>
+
+/* @brief A curve file of a Workspace
+ * */
+typedef struct
+{
+    /* Path the curve is loaded from */
+    char *fileName;
+    Curve *curve;
+    /* Compressed points or NULL, curve is left empty while packed */
+    PackedCurve *packed;
+    /* Result of the last load */
+    LoadStatus status;
+    bool isLoaded;
+    /* False if the last save failed */
+    bool isSaved;
+    /* Wall time of the last operation on this curve */
+    double seconds;
+}WorkspaceEntry;
+
+/* @brief A set of curves processed together
+ *
+ * Every operation runs one task per curve on a shared WorkerPool, so
+ * large & small files balance over the threads. Each curve is loaded &
+ * analyzed with a single thread to keep the pool from being oversubscribed.
+ * */
+typedef struct
+{
+    WorkspaceEntry *entries;
+    size_t count;
+    size_t capacity;
+    WorkerPool *pool;
+}Workspace;
+
+/* @brief Allocates memory for an empty Workspace
+ * @param threads Number of threads, 0 for getStatsThreads
+ * @return Memory of new Workspace or NULL
+ * */
+Workspace *mkWorkspace(int threads);
+
+/* @brief Frees a Workspace & its curves
+ * @param *workspace Target Workspace, may be NULL
+ * */
+void rmWorkspace(Workspace *workspace);
+
+/* @brief Adds a curve file to a Workspace, the file is read by
+ * workspace_Load
+ * @param *workspace Target Workspace
+ * @param *fileName Path of the file
+ * @return Returns false if memory could not be allocated
+ * */
+bool workspace_Add(Workspace *workspace, const char *fileName);
+
+/* @brief Adds every regular, non hidden file of a directory in name order
+ * @param *workspace Target Workspace
+ * @param *directory Path of the directory
+ * @return Number of files added or -1 if the directory could not be read
+ * */
+int workspace_AddDirectory(Workspace *workspace, const char *directory);
+
+/* @brief Loads every curve of a Workspace in parallel
+ * @param *workspace Target Workspace
+ * @return Number of curves loaded without error
+ * */
+size_t workspace_Load(Workspace *workspace);
+
+/* @brief Recalculates the statistics of every loaded curve in parallel
+ * @param *workspace Target Workspace
+ * */
+void workspace_Analyze(Workspace *workspace);
+
+/* @brief Shifts every loaded curve
+ * @param *workspace Target Workspace
+ * @param shiftX Value to shift X
+ * @param shiftY Value to shift Y
+ * */
+void workspace_Shift(Workspace *workspace, double shiftX, double shiftY);
+
+/* @brief Saves every loaded curve to a directory in parallel
+ *
+ * Files keep their base names & format, existing files are not replaced.
+ * @param *workspace Target Workspace
+ * @param *directory Output directory
+ * @param isDurable True to sync & rename each file into place
+ * @return Number of curves that could not be saved
+ * */
+size_t workspace_Save(Workspace *workspace, const char *directory, bool isDurable);
+
+/* @brief Compresses every loaded curve in parallel & frees its arrays
+ *
+ * Packed curves are still analyzed, shifted & saved, blocks are decoded
+ * as they are needed. Loading a curve again unpacks it.
+ * @param *workspace Target Workspace
+ * @return Number of curves that could not be packed
+ * */
+size_t workspace_Pack(Workspace *workspace);
+
+/* @brief Gets the number of points of a curve of a Workspace
+ * @param *entry Target WorkspaceEntry
+ * @return Number of points, packed or not
+ * */
+size_t workspaceEntry_Points(WorkspaceEntry *entry);
+
+/* @brief Gets the memory held by the points of a curve of a Workspace
+ * @param *entry Target WorkspaceEntry
+ * @return Bytes of the arrays or of the PackedCurve
+ * */
+size_t workspaceEntry_Bytes(WorkspaceEntry *entry);
+
+/* @brief Gets the statistics of a curve of a Workspace
+ * @param *entry Target WorkspaceEntry
+ * @param *length Filled with the length of the curve
+ * @param *area Filled with the area under the curve
+ * @return Returns false if the statistics are not up to date
+ * */
+bool workspaceEntry_Stats(WorkspaceEntry *entry, double *length, double *area);
+
+/* @brief Describes the state of a curve of a Workspace
+ * @param *entry Target WorkspaceEntry
+ * @return Short status text
+ * */
+const char *workspaceEntry_Status(WorkspaceEntry *entry);
+#endif